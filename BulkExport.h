@@ -0,0 +1,367 @@
+#ifndef _BULK_EXPORT_H
+#define _BULK_EXPORT_H
+
+#include "TravelOptions.h"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * class: BulkExport
+ * desc: fast writers for dumping (large) TravelOptions objects to files, pipes or sockets
+ *       given as file descriptors:
+ *
+ *         - write_csv:     "price,time" lines
+ *         - write_jsonl:   one {"price":p,"time":t} object per line
+ *         - write_binary:  raw column format (see write_binary), read back by read_binary
+ *
+ *       The text writers walk the list directly (no to_vec copy) and format into a 1 MiB
+ *       buffer which is handed to write() when full, so there is one system call per
+ *       megabyte instead of a printf per option.  Numbers are written as the shortest
+ *       decimal that reads back as exactly the same double:  whole numbers and values with
+ *       up to 6 decimals (minutes, cents, ...) are formatted with integer arithmetic, and only
+ *       other values go through snprintf/strtod.
+ *
+ *       All writers return false if a write fails (errno tells why); what was written
+ *       before the failure stays written.
+ */
+class BulkExport {
+
+public:
+  enum { MAX_FIELD = 32 };  // most characters format() writes for one number
+
+private:
+  enum { BUFFER = 1 << 20, CHUNK = 1 << 16 };
+
+  // output buffer flushed to fd whenever fewer than MAX_FIELD*4 bytes are left
+  class Out {
+    int fd;
+    std::vector<char> buf;
+    size_t len;
+    bool ok;
+
+  public:
+    Out(int _fd) : fd(_fd), buf(BUFFER), len(0), ok(true) {}
+
+    char * room() {
+      if(BUFFER - len < MAX_FIELD * 4)
+        flush();
+      return &buf[len];
+    }
+
+    void advance(char *end) {
+      len = end - &buf[0];
+    }
+
+    bool flush() {
+      if(ok && len > 0)
+        ok = write_all(fd, &buf[0], len);
+      len = 0;
+      return ok;
+    }
+  };
+
+  struct Header {
+    char magic[8];
+    uint64_t count;
+  };
+
+public:
+
+  /**
+ * func: write_csv
+ * desc: writes the options (in list order) as "price,time" lines, preceded by a
+ *       "price,time" header line unless header is false.
+ *
+ * RUNTIME:  O(n)
+ */
+  static bool write_csv(const TravelOptions &options, int fd, bool header = true) {
+    Out out(fd);
+    if(header) {
+      char *p = out.room();
+      std::memcpy(p, "price,time\n", 11);
+      out.advance(p + 11);
+    }
+    for(TravelOptions::const_iterator it = options.begin(); it != options.end(); ++it) {
+      char *p = format(it->price, out.room());
+      *p++ = ',';
+      p = format(it->time, p);
+      *p++ = '\n';
+      out.advance(p);
+    }
+    return out.flush();
+  }
+
+  /**
+ * func: write_jsonl
+ * desc: writes the options (in list order) as JSON lines:  {"price":p,"time":t}.
+ *       Values which are not finite (not representable in JSON) are written as null.
+ *
+ * RUNTIME:  O(n)
+ */
+  static bool write_jsonl(const TravelOptions &options, int fd) {
+    Out out(fd);
+    for(TravelOptions::const_iterator it = options.begin(); it != options.end(); ++it) {
+      char *p = out.room();
+      std::memcpy(p, "{\"price\":", 9);
+      p = format_json(it->price, p + 9);
+      std::memcpy(p, ",\"time\":", 8);
+      p = format_json(it->time, p + 8);
+      *p++ = '}';
+      *p++ = '\n';
+      out.advance(p);
+    }
+    return out.flush();
+  }
+
+  /**
+ * func: write_binary
+ * desc: writes the options in a raw column format:  a 16 byte header (the 8 characters
+ *       "TRVLOPT1" and the number of options as a uint64), all the prices, then all the
+ *       times (in list order), every number in the machine's native representation
+ *       (little-endian IEEE doubles on the usual platforms).
+ *
+ *       Each column is gathered from the list CHUNK (64K) options at a time into one
+ *       512 KiB buffer which goes out with writev (the header with the first price chunk),
+ *       so memory use does not grow with the list:  two passes over the list, no formatting.
+ *
+ * RUNTIME:  O(n)
+ */
+  static bool write_binary(const TravelOptions &options, int fd) {
+    Header h;
+    std::memcpy(h.magic, "TRVLOPT1", 8);
+    h.count = options.size();
+
+    std::vector<double> chunk(std::min<uint64_t>(h.count, CHUNK));
+    return write_column(options, &TravelOptions::Option::price, chunk, &h, sizeof(h), fd) &&
+           write_column(options, &TravelOptions::Option::time, chunk, nullptr, 0, fd);
+  }
+
+  /**
+ * func: read_binary
+ * desc: reads back a list written by write_binary.  The columns are read CHUNK options at
+ *       a time, so memory grows with the data actually there, not with the count in the
+ *       header (a truncated or corrupt file fails where its data ends).
+ * returns: a new TravelOptions object (options in the order written), or nullptr if the
+ *          data is not in that format or cannot be read completely.
+ *
+ * RUNTIME:  O(n)
+ */
+  static TravelOptions * read_binary(int fd) {
+    Header h;
+    if(!read_all(fd, &h, sizeof(h)) || std::memcmp(h.magic, "TRVLOPT1", 8) != 0)
+      return nullptr;
+    if(h.count > (uint64_t)INT_MAX)
+      return nullptr;
+
+    std::vector<double> prices, times;
+    if(!read_column(fd, h.count, prices) || !read_column(fd, h.count, times))
+      return nullptr;
+
+    TravelOptions *options = new TravelOptions();
+    for(size_t i=h.count; i>0; i--)
+      options->push_front(prices[i-1], times[i-1]);
+    return options;
+  }
+
+  /**
+ * func: format
+ * desc: writes the shortest decimal form of v which reads back (strtod) as exactly v, and
+ *       returns the end of what was written (at most MAX_FIELD characters, no terminator).
+ *       Not finite values are written as nan, inf or -inf.
+ */
+  static char * format(double v, char *out) {
+    static const double pow10[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+
+    if(!std::isfinite(v)) {
+      const char *s = (v != v) ? "nan" : (v < 0 ? "-inf" : "inf");
+      size_t n = std::strlen(s);
+      std::memcpy(out, s, n);
+      return out + n;
+    }
+    if(std::signbit(v)) {
+      *out++ = '-';
+      v = -v;
+    }
+
+    // v = n / 10^k exactly as strtod would read it (both are correctly rounded)
+    if(v < 9007199254740992.0) {
+      for(int k=0; k<=6; k++) {
+        double x = v * pow10[k];
+        if(x >= 9007199254740992.0)
+          break;
+        uint64_t n = (uint64_t)std::llround(x);
+        if((double)n / pow10[k] == v)
+          return fixed(n, k, out);
+      }
+    }
+
+    // if a decimal of at most 15 digits reads back as v, %.15g prints it (trailing zeros
+    // dropped); subnormals have fewer bits, so there shorter precisions are tried too
+    char tmp[MAX_FIELD];
+    for(int precision = (v < 2.2250738585072014e-308) ? 1 : 15; precision<=17; precision++) {
+      snprintf(tmp, sizeof(tmp), "%.*g", precision, v);
+      if(precision == 17 || std::strtod(tmp, nullptr) == v)
+        break;
+    }
+    size_t n = std::strlen(tmp);
+    std::memcpy(out, tmp, n);
+    return out + n;
+  }
+
+private:
+
+  static char * format_json(double v, char *out) {
+    if(!std::isfinite(v)) {
+      std::memcpy(out, "null", 4);
+      return out + 4;
+    }
+    return format(v, out);
+  }
+
+  // writes n / 10^k with exactly k decimals (n < 2^53, so at most 16 digits)
+  static char * fixed(uint64_t n, int k, char *out) {
+    static const char pairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+    char digits[24];
+    char *d = digits + sizeof(digits);
+    while(n >= 100) {
+      d -= 2;
+      std::memcpy(d, pairs + 2*(n % 100), 2);
+      n /= 100;
+    }
+    if(n >= 10) {
+      d -= 2;
+      std::memcpy(d, pairs + 2*n, 2);
+    }
+    else
+      *--d = (char)('0' + n);
+
+    int len = digits + sizeof(digits) - d;
+    if(k == 0) {
+      std::memcpy(out, d, len);
+      return out + len;
+    }
+    if(len <= k) {  // 0.00ddd
+      *out++ = '0';
+      *out++ = '.';
+      for(int i=len; i<k; i++)
+        *out++ = '0';
+      std::memcpy(out, d, len);
+      return out + len;
+    }
+    std::memcpy(out, d, len - k);
+    out += len - k;
+    *out++ = '.';
+    std::memcpy(out, d + len - k, k);
+    return out + k;
+  }
+
+  // writes field of every option, chunk.size() at a time, the first chunk preceded by head
+  static bool write_column(const TravelOptions &options, double TravelOptions::Option::*field,
+                           std::vector<double> &chunk, const void *head, size_t head_len, int fd) {
+    TravelOptions::const_iterator it = options.begin();
+    do {
+      size_t k = 0;
+      for(; k < chunk.size() && it != options.end(); ++it, k++)
+        chunk[k] = (*it).*field;
+
+      struct iovec iov[2];
+      iov[0].iov_base = const_cast<void *>(head);
+      iov[0].iov_len = head_len;
+      iov[1].iov_base = chunk.data();
+      iov[1].iov_len = k * sizeof(double);
+      if(!writev_all(fd, iov, 2))
+        return false;
+      head_len = 0;
+    } while(it != options.end());
+    return true;
+  }
+
+  static bool write_all(int fd, const char *data, size_t len) {
+    while(len > 0) {
+      ssize_t n = ::write(fd, data, len);
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        return false;
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  // writev, resumed after partial writes (and in pieces of at most 1 GiB per buffer)
+  static bool writev_all(int fd, struct iovec *iov, int cnt) {
+    while(cnt > 0) {
+      if(iov[0].iov_len == 0) {
+        iov++;
+        cnt--;
+        continue;
+      }
+      struct iovec part[3];
+      int k = 0;
+      for(; k<cnt && k<3; k++) {
+        part[k] = iov[k];
+        if(part[k].iov_len > (1u << 30))
+          part[k].iov_len = 1u << 30;
+      }
+      ssize_t n = ::writev(fd, part, k);
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        return false;
+      for(size_t done = n; done > 0; ) {
+        size_t step = done < iov[0].iov_len ? done : iov[0].iov_len;
+        iov[0].iov_base = (char *)iov[0].iov_base + step;
+        iov[0].iov_len -= step;
+        done -= step;
+        if(iov[0].iov_len == 0) {
+          iov++;
+          cnt--;
+        }
+      }
+    }
+    return true;
+  }
+
+  // appends n doubles read from fd to column, CHUNK at a time
+  static bool read_column(int fd, uint64_t n, std::vector<double> &column) {
+    while(column.size() < n) {
+      size_t k = std::min<uint64_t>(n - column.size(), CHUNK);
+      column.resize(column.size() + k);
+      if(!read_all(fd, &column[column.size() - k], k * sizeof(double)))
+        return false;
+    }
+    return true;
+  }
+
+  static bool read_all(int fd, void *data, size_t len) {
+    char *p = (char *)data;
+    while(len > 0) {
+      ssize_t n = ::read(fd, p, len);
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        return false;
+      p += n;
+      len -= n;
+    }
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,321 @@
+#ifndef _COMPRESSED_FRONTIER_H
+#define _COMPRESSED_FRONTIER_H
+
+#include "TravelOptions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+/**
+ * class: CompressedFrontier
+ * desc: compact, read-only copy of a pareto-sorted TravelOptions object, for keeping large
+ *       numbers of frontiers in memory (a list costs a 24 byte Node, plus allocator overhead,
+ *       per option).
+ *
+ *       In a pareto-sorted list prices strictly increase and times strictly decrease, so each
+ *       column is stored as positive deltas between consecutive options.  Values are first
+ *       mapped to integer codes that preserve their order:  if every value of a column is an
+ *       exact multiple of a power of ten (whole minutes, cents, ...) the code is that scaled
+ *       integer, which keeps deltas small; otherwise it is the (order-preserving) bit pattern
+ *       of the double.  Either way decoding gives back exactly the same doubles.
+ *
+ *       Options are grouped in blocks of BLOCK.  Each block has an uncompressed header with
+ *       its first option, so lookups binary search the headers and decode a single block.
+ *       Within a block every delta of a column is stored with the same number of bytes (the
+ *       fewest that fit the block's largest delta), so decoding a column is one scalar loop
+ *       of fixed-stride 8 byte loads, a mask and a running sum, with the direction of the sum
+ *       fixed at compile time.  (A running sum does not vectorize; widening the deltas into a
+ *       separate array first, in a loop that does, measured slower than this single pass.)
+ */
+class CompressedFrontier {
+
+public:
+  enum { BLOCK = 64 };
+
+private:
+  struct Block {
+    uint64_t price;     // codes of the block's first option
+    uint64_t time;
+    uint64_t offset;    // start of the block's deltas in data (can pass 4 GiB)
+    uint8_t pw, tw;     // bytes per price / time delta
+  };
+
+  struct Column {
+    double scale;       // codes are value*scale, or the double's bits if scale == 0
+  };
+
+  Column pcol, tcol;
+  int _size;
+  std::vector<Block> blocks;
+  std::vector<uint8_t> data;   // padded with 8 bytes so every load can read a full word
+
+  CompressedFrontier() {
+    _size = 0;
+    pcol.scale = tcol.scale = 0;
+  }
+
+public:
+
+  /**
+ * func: compress
+ * desc: builds the compressed form of a pareto-sorted list.
+ * returns: a pointer to the new object, or nullptr if options is not pareto-sorted.
+ *
+ * RUNTIME:  O(n)
+ */
+  static CompressedFrontier * compress(const TravelOptions &options) {
+    if(!options.is_pareto_sorted())
+      return nullptr;
+
+    CompressedFrontier *cf = new CompressedFrontier();
+    size_t n = options.size();
+    cf->_size = n;
+    cf->pcol.scale = pick_scale(options, &TravelOptions::Option::price);
+    cf->tcol.scale = pick_scale(options, &TravelOptions::Option::time);
+
+    // one block of codes at a time, straight from the list
+    TravelOptions::const_iterator it = options.begin();
+    uint64_t pc[BLOCK], tc[BLOCK];
+    for(size_t b=0; b<n; b+=BLOCK) {
+      size_t m = std::min(n - b, (size_t)BLOCK);
+      for(size_t i=0; i<m; i++, ++it) {
+        pc[i] = encode(cf->pcol, it->price);
+        tc[i] = encode(cf->tcol, it->time);
+      }
+
+      Block blk;
+      blk.price = pc[0];
+      blk.time = tc[0];
+      blk.offset = cf->data.size();
+
+      uint64_t pmax = 0, tmax = 0;
+      for(size_t i=1; i<m; i++) {
+        pmax |= pc[i] - pc[i-1];
+        tmax |= tc[i-1] - tc[i];
+      }
+      blk.pw = width(pmax);
+      blk.tw = width(tmax);
+      for(size_t i=1; i<m; i++)
+        put(cf->data, pc[i] - pc[i-1], blk.pw);
+      for(size_t i=1; i<m; i++)
+        put(cf->data, tc[i-1] - tc[i], blk.tw);
+      cf->blocks.push_back(blk);
+    }
+    cf->data.resize(cf->data.size() + 8, 0);
+    cf->data.shrink_to_fit();
+    return cf;
+  }
+
+  /**
+ * func: size
+ * desc: returns the number of options
+ */
+  int size() const {
+    return _size;
+  }
+
+  /**
+ * func: bytes
+ * desc: returns the memory used by the compressed options (headers and deltas)
+ */
+  size_t bytes() const {
+    return sizeof(*this) + blocks.capacity() * sizeof(Block) + data.capacity();
+  }
+
+  /**
+ * func: decode
+ * desc: decodes all options into two columns (in sorted order).
+ *
+ * RUNTIME:  O(n)
+ */
+  void decode(std::vector<double> &prices, std::vector<double> &times) const {
+    prices.resize(_size);
+    times.resize(_size);
+    for(size_t b=0; b<blocks.size(); b++)
+      decode_block(b, &prices[b*BLOCK], &times[b*BLOCK]);
+  }
+
+  /**
+ * func: decompress
+ * desc: returns the options as a new (pareto-sorted) TravelOptions object.
+ *
+ * RUNTIME:  O(n)
+ */
+  TravelOptions * decompress() const {
+    TravelOptions *options = new TravelOptions();
+    double prices[BLOCK], times[BLOCK];
+
+    for(size_t b=blocks.size(); b>0; b--) {
+      int n = decode_block(b-1, prices, times);
+      for(int i=n-1; i>=0; i--)
+        options->push_front(prices[i], times[i]);
+    }
+    return options;
+  }
+
+  /**
+ * func: fastest_within_budget
+ * desc: finds the fastest option with price <= budget (the most expensive one that fits).
+ * returns: false if every option costs more than budget.
+ *
+ * RUNTIME:  O(log n + BLOCK):  one block is decoded.
+ */
+  bool fastest_within_budget(double budget, double &price, double &time) const {
+    // last block starting at or below the budget
+    size_t lo = 0, hi = blocks.size();
+    while(lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if(decode_value(pcol, blocks[mid].price) <= budget)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if(lo == 0)
+      return false;
+
+    double prices[BLOCK], times[BLOCK];
+    int n = decode_block(lo-1, prices, times);
+    int i = n - 1;
+    while(prices[i] > budget)
+      i--;
+    price = prices[i];
+    time = times[i];
+    return true;
+  }
+
+  /**
+ * func: cheapest_within_time
+ * desc: finds the cheapest option with time <= max_time.
+ * returns: false if every option takes longer than max_time.
+ *
+ * RUNTIME:  O(log n + BLOCK):  at most one block is decoded.
+ */
+  bool cheapest_within_time(double max_time, double &price, double &time) const {
+    // first block whose first option is fast enough
+    size_t lo = 0, hi = blocks.size();
+    while(lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if(decode_value(tcol, blocks[mid].time) > max_time)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    // the answer may be further into the previous block
+    if(lo > 0) {
+      double prices[BLOCK], times[BLOCK];
+      int n = decode_block(lo-1, prices, times);
+      for(int i=0; i<n; i++) {
+        if(times[i] <= max_time) {
+          price = prices[i];
+          time = times[i];
+          return true;
+        }
+      }
+    }
+    if(lo == blocks.size())
+      return false;
+    price = decode_value(pcol, blocks[lo].price);
+    time = decode_value(tcol, blocks[lo].time);
+    return true;
+  }
+
+private:
+
+  // smallest power of ten (up to 10^6) which turns every value of the column field into
+  // an exact integer, else 0 (a scale that does not fit is usually ruled out early)
+  static double pick_scale(const TravelOptions &options, double TravelOptions::Option::*field) {
+    for(double s=1; s<=1e6; s*=10) {
+      bool ok = true;
+      for(TravelOptions::const_iterator it = options.begin(); it != options.end() && ok; ++it) {
+        double v = (*it).*field, x = v * s;
+        ok = std::fabs(x) < 9007199254740992.0 && (double)std::llround(x) / s == v;
+      }
+      if(ok)
+        return s;
+    }
+    return 0;
+  }
+
+  static uint64_t encode(const Column &c, double v) {
+    uint64_t u;
+    if(c.scale != 0)
+      return (uint64_t)std::llround(v * c.scale) ^ 0x8000000000000000ULL;
+    std::memcpy(&u, &v, sizeof(u));
+    return (u & 0x8000000000000000ULL) ? ~u : (u | 0x8000000000000000ULL);
+  }
+
+  static double decode_value(const Column &c, uint64_t u) {
+    if(c.scale != 0)
+      return (double)(int64_t)(u ^ 0x8000000000000000ULL) / c.scale;
+    u = (u & 0x8000000000000000ULL) ? (u & ~0x8000000000000000ULL) : ~u;
+    double d;
+    std::memcpy(&d, &u, sizeof(d));
+    return d;
+  }
+
+  static uint8_t width(uint64_t x) {
+    uint8_t w = 0;
+    while(x != 0) {
+      w++;
+      x >>= 8;
+    }
+    return w;
+  }
+
+  static void put(std::vector<uint8_t> &out, uint64_t x, int w) {
+    for(int i=0; i<w; i++)
+      out.push_back((uint8_t)(x >> (8*i)));
+  }
+
+  // fixed-stride little-endian load of w bytes (reads a full word; data is padded), summed
+  // up (rising prices) or down (falling times)
+  template <bool DOWN>
+  static void unpack(const uint8_t *src, int w, int n, uint64_t first, uint64_t *out) {
+    uint64_t mask = (w == 8) ? ~0ULL : ((1ULL << (8*w)) - 1);
+    uint64_t acc = first;
+    out[0] = first;
+    for(int i=1; i<n; i++) {
+      uint64_t d;
+      std::memcpy(&d, src + (size_t)(i-1)*w, sizeof(d));
+      d &= mask;
+      acc = DOWN ? acc - d : acc + d;
+      out[i] = acc;
+    }
+  }
+
+  // decodes block b into prices/times; returns the number of options in it
+  int decode_block(size_t b, double *prices, double *times) const {
+    const Block &blk = blocks[b];
+    int n = std::min((int)BLOCK, _size - (int)(b*BLOCK));
+    uint64_t pc[BLOCK], tc[BLOCK];
+    const uint8_t *src = &data[blk.offset];
+
+    unpack<false>(src, blk.pw, n, blk.price, pc);
+    unpack<true>(src + (size_t)(n-1)*blk.pw, blk.tw, n, blk.time, tc);
+
+    if(pcol.scale != 0) {
+      for(int i=0; i<n; i++)
+        prices[i] = (double)(int64_t)(pc[i] ^ 0x8000000000000000ULL) / pcol.scale;
+    }
+    else {
+      for(int i=0; i<n; i++)
+        prices[i] = decode_value(pcol, pc[i]);
+    }
+    if(tcol.scale != 0) {
+      for(int i=0; i<n; i++)
+        times[i] = (double)(int64_t)(tc[i] ^ 0x8000000000000000ULL) / tcol.scale;
+    }
+    else {
+      for(int i=0; i<n; i++)
+        times[i] = decode_value(tcol, tc[i]);
+    }
+    return n;
+  }
+};
+
+#endif
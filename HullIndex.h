@@ -0,0 +1,272 @@
+#ifndef _HULL_INDEX_H
+#define _HULL_INDEX_H
+
+#include "TravelOptions.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+
+/**
+ * class: HullIndex
+ * desc: index over a (pareto-sorted) TravelOptions object answering weighted
+ *       scalarization queries: for a value-of-time lambda >= 0, which option minimizes
+ *
+ *            price + lambda * time
+ *
+ *       Only options on the lower convex hull of the <price,time> points can be such a
+ *       minimizer.  Walking the hull in order of increasing price, the breakpoint between
+ *       consecutive vertices a and b is the lambda at which both score the same,
+ *
+ *            (b.price - a.price) / (a.time - b.time),
+ *
+ *       and these breakpoints increase along the hull.  The minimizer for lambda is the
+ *       left vertex of the first breakpoint >= lambda (or the last vertex if there is none),
+ *       so a query is a single lookup in a map keyed by breakpoint.
+ *
+ *       The index subscribes to the list it was built from and is kept up to date as
+ *       options are inserted (e.g. insert_pareto_sorted) or removed.  Removing a hull vertex
+ *       re-hulls the options between its neighbours, which can be most of the list (e.g.,
+ *       for a concave frontier the hull is just its two ends); bulk changes such as clear
+ *       arrive as a single reloaded call and rebuild the hull once instead.
+ */
+class HullIndex : public TravelOptions::Observer {
+
+  typedef std::pair<double, double> Option;  // <price,time>
+
+  const TravelOptions *src;
+  std::multiset<Option> points;              // every option of src, ordered by price then time
+  std::map<double, double> hull;             // hull vertices: price -> time
+  std::multimap<double, Option> breaks;      // breakpoint -> left vertex of that hull edge
+
+public:
+  /**
+ * func: constructor
+ * desc: builds the hull over the options currently in the given list and subscribes to it.
+ *
+ * RUNTIME:  O(n log n)
+ */
+  HullIndex(const TravelOptions &options) {
+    src = &options;
+    reloaded(options);
+    src->subscribe(this);
+  }
+
+  ~HullIndex() {
+    if(src != nullptr)
+      src->unsubscribe(this);
+  }
+
+  /**
+ * func: size
+ * desc: number of options on the hull (i.e., the number of distinct possible answers)
+ */
+  int size() const {
+    return hull.size();
+  }
+
+  /**
+ * func: argmin
+ * desc: finds the option minimizing price + lambda*time.  Ties are broken in favor
+ *       of the cheaper option.
+ * returns: false (and leaves price/time untouched) if the index is empty or lambda < 0.
+ *
+ * RUNTIME:  O(log n)
+ */
+  bool argmin(double lambda, double &price, double &time) const {
+    if(hull.empty() || lambda < 0)
+      return false;
+
+    std::multimap<double, Option>::const_iterator it = breaks.lower_bound(lambda);
+    if(it == breaks.end()) {
+      price = hull.rbegin()->first;
+      time = hull.rbegin()->second;
+    }
+    else {
+      price = it->second.first;
+      time = it->second.second;
+    }
+    return true;
+  }
+
+  /**
+ * func: argmin_sorted
+ * desc: answers a whole batch of queries; lambdas must be non-negative and sorted in
+ *       non-decreasing order.  out[i] receives the <price,time> minimizer for lambdas[i].
+ * returns: false if the index is empty or lambdas is not sorted/non-negative.
+ *
+ * RUNTIME:  O(h + k) for h hull vertices and k queries.
+ */
+  bool argmin_sorted(const std::vector<double> &lambdas, std::vector<Option> &out) const {
+    if(hull.empty())
+      return false;
+    for(size_t i=0; i<lambdas.size(); i++) {
+      if(lambdas[i] < 0 || (i > 0 && lambdas[i] < lambdas[i-1]))
+        return false;
+    }
+
+    out.resize(lambdas.size());
+    Option last(hull.rbegin()->first, hull.rbegin()->second);
+    std::multimap<double, Option>::const_iterator it = breaks.begin();
+
+    for(size_t i=0; i<lambdas.size(); i++) {
+      while(it != breaks.end() && it->first < lambdas[i])
+        ++it;
+      out[i] = (it == breaks.end()) ? last : it->second;
+    }
+    return true;
+  }
+
+  /*
+   * TravelOptions::Observer interface
+   */
+  void option_inserted(const TravelOptions &, double price, double time) {
+    points.insert(Option(price, time));
+    hull_insert(price, time);
+  }
+
+  void option_removed(const TravelOptions &, double price, double time) {
+    Option opt(price, time);
+    std::multiset<Option>::iterator p = points.find(opt);
+    if(p == points.end())
+      return;
+    points.erase(p);
+
+    std::map<double, double>::iterator v = hull.find(price);
+    if(v == hull.end() || v->second != time || points.count(opt) > 0)
+      return;  // not a hull vertex (or a duplicate of it is still there)
+
+    // re-hull the pocket of options between the removed vertex's neighbours:
+    // O(k log n) for k options in the pocket
+    std::map<double, double>::iterator r = erase_vertex(v);
+    std::multiset<Option>::iterator lo = points.begin(), hi = points.end();
+    if(r != hull.begin()) {
+      std::map<double, double>::iterator l = r;
+      --l;
+      lo = points.upper_bound(Option(l->first, l->second));
+    }
+    if(r != hull.end())
+      hi = points.lower_bound(Option(r->first, r->second));
+    for(; lo != hi; ++lo)
+      hull_insert(lo->first, lo->second);
+  }
+
+  // rebuilds everything from the list:  O(n log n)
+  void reloaded(const TravelOptions &options) {
+    points.clear();
+    hull.clear();
+    breaks.clear();
+    for(TravelOptions::const_iterator it = options.begin(); it != options.end(); ++it)
+      points.insert(Option(it->price, it->time));
+    // in price order every insertion lands at the right end of the hull (amortized O(log n))
+    for(std::multiset<Option>::const_iterator p = points.begin(); p != points.end(); ++p)
+      hull_insert(p->first, p->second);
+  }
+
+  void detached(const TravelOptions &) {
+    src = nullptr;
+  }
+
+private:
+
+  // is m strictly below the segment from a to b (a.price < m.price < b.price)?
+  static bool below(double ap, double at, double mp, double mt, double bp, double bt) {
+    return (mt - at) * (bp - ap) < (bt - at) * (mp - ap);
+  }
+
+  static double breakpoint(std::map<double, double>::const_iterator a,
+                           std::map<double, double>::const_iterator b) {
+    return (b->first - a->first) / (a->second - b->second);
+  }
+
+  void link(std::map<double, double>::iterator a, std::map<double, double>::iterator b) {
+    breaks.insert(std::make_pair(breakpoint(a, b), Option(a->first, a->second)));
+  }
+
+  void unlink(std::map<double, double>::iterator a, std::map<double, double>::iterator b) {
+    double key = breakpoint(a, b);
+    std::multimap<double, Option>::iterator it = breaks.lower_bound(key);
+    for(; it != breaks.end() && it->first == key; ++it) {
+      if(it->second.first == a->first) {
+        breaks.erase(it);
+        return;
+      }
+    }
+  }
+
+  // removes hull vertex v (and its edges), joins its neighbours; returns the right neighbour
+  std::map<double, double>::iterator erase_vertex(std::map<double, double>::iterator v) {
+    std::map<double, double>::iterator l = v, r = v;
+    ++r;
+    bool has_l = (v != hull.begin());
+    if(has_l) {
+      --l;
+      unlink(l, v);
+    }
+    if(r != hull.end())
+      unlink(v, r);
+    hull.erase(v);
+    if(has_l && r != hull.end())
+      link(l, r);
+    return r;
+  }
+
+  /*
+   * Adds <price,time> to the hull if it lies strictly below it, then drops the
+   * neighbours on either side which are no longer convex (or are now dominated).
+   * Amortized O(log n).
+   */
+  void hull_insert(double price, double time) {
+    std::map<double, double>::iterator r = hull.lower_bound(price);
+    if(r != hull.end() && r->first == price) {
+      if(r->second <= time)
+        return;
+      r = erase_vertex(r);
+    }
+    std::map<double, double>::iterator l = r;
+    if(r != hull.begin()) {
+      --l;
+      if(l->second <= time)
+        return;  // dominated by a cheaper option
+      if(r != hull.end() && !below(l->first, l->second, price, time, r->first, r->second))
+        return;  // on or above the hull
+    }
+
+    // right neighbours which are dominated or no longer below the new edge
+    while(r != hull.end()) {
+      std::map<double, double>::iterator r2 = r;
+      ++r2;
+      if(r->second < time && (r2 == hull.end() || below(price, time, r->first, r->second, r2->first, r2->second)))
+        break;
+      r = erase_vertex(r);
+    }
+    // left neighbours which are no longer below the new edge
+    while(r != hull.begin()) {
+      std::map<double, double>::iterator l1 = r;
+      --l1;
+      if(l1 == hull.begin())
+        break;
+      std::map<double, double>::iterator l2 = l1;
+      --l2;
+      if(below(l2->first, l2->second, l1->first, l1->second, price, time))
+        break;
+      erase_vertex(l1);
+    }
+
+    bool has_l = (r != hull.begin());
+    if(has_l) {
+      l = r;
+      --l;
+      if(r != hull.end())
+        unlink(l, r);
+    }
+    std::map<double, double>::iterator v = hull.insert(r, std::make_pair(price, time));
+    if(has_l)
+      link(l, v);
+    if(r != hull.end())
+      link(v, r);
+  }
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef _MATERIALIZED_JOIN_H
+#define _MATERIALIZED_JOIN_H
+
+#include "TravelOptions.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+
+/**
+ * class: MaterializedJoin
+ * desc: a join_plus_plus or join_plus_max result which is kept up to date as its two
+ *       input lists ("legs") change, instead of being recomputed from scratch.
+ *
+ *       The join subscribes to both legs.  When an option is inserted into one leg only
+ *       its pairings with the other leg are computed (M candidates) and merged into the
+ *       stored frontier, exactly as union_pareto_sorted would merge them:  O(M log F) for
+ *       a frontier of F options.
+ *
+ *       Each frontier entry remembers how many live pairs produce it.  When an option is
+ *       deleted from a leg its M pairings are retracted from those counts; frontier
+ *       entries that reach zero are dropped, and only the price range each one used to
+ *       cover (up to the next surviving entry) is rescanned for pairs which are no
+ *       longer dominated.  Bulk changes to a leg (clear, ...) arrive as a single reloaded
+ *       call, which re-reads that leg and recomputes the join once.
+ */
+class MaterializedJoin : public TravelOptions::Observer {
+
+public:
+  enum Kind { plus_plus, plus_max };
+
+private:
+  typedef std::pair<double, double> Option;     // <price,time>
+  typedef std::map<double, std::pair<double, int> > Frontier;  // price -> <time, #pairs>
+
+  Kind kind;
+  const TravelOptions *first;
+  const TravelOptions *second;
+  std::multiset<Option> leg1, leg2;             // mirrors of the two legs, ordered by price
+  Frontier frontier;
+
+public:
+  /**
+ * func: constructor
+ * desc: computes the join of the two legs (first leg is the calling object of the
+ *       corresponding TravelOptions::join_* function) and subscribes to both.
+ *       The legs need not be sorted or pareto.
+ *
+ * RUNTIME:  O(N*M log F)
+ */
+  MaterializedJoin(const TravelOptions &_first, const TravelOptions &_second, Kind _kind = plus_plus) {
+    kind = _kind;
+    first = &_first;
+    second = &_second;
+    load(_first, leg1);
+    load(_second, leg2);
+    recompute();
+
+    first->subscribe(this);
+    if(second != first)
+      second->subscribe(this);
+  }
+
+  ~MaterializedJoin() {
+    if(first != nullptr)
+      first->unsubscribe(this);
+    if(second != nullptr && second != first)
+      second->unsubscribe(this);
+  }
+
+  /**
+ * func: size
+ * desc: number of options in the (pareto) join result
+ */
+  int size() const {
+    return frontier.size();
+  }
+
+  /**
+ * func: result
+ * desc: returns the current join result as a new sorted-pareto TravelOptions object.
+ *
+ * RUNTIME:  O(F)
+ */
+  TravelOptions * result() const {
+    TravelOptions *options = new TravelOptions();
+    for(Frontier::const_reverse_iterator it = frontier.rbegin(); it != frontier.rend(); ++it)
+      options->push_front(it->first, it->second.first);
+    return options;
+  }
+
+  /*
+   * TravelOptions::Observer interface
+   */
+  void option_inserted(const TravelOptions &src, double price, double time) {
+    Option opt(price, time);
+    std::multiset<Option>::const_iterator it;
+
+    if(&src == first) {
+      leg1.insert(opt);
+      for(it = leg2.begin(); it != leg2.end(); ++it)
+        add_pair(opt, *it);
+    }
+    if(&src == second) {
+      leg2.insert(opt);
+      for(it = leg1.begin(); it != leg1.end(); ++it)
+        add_pair(*it, opt);
+    }
+  }
+
+  void option_removed(const TravelOptions &src, double price, double time) {
+    Option opt(price, time);
+    std::multiset<Option>::iterator p;
+    std::multiset<Option>::const_iterator it;
+    std::vector<double> dead;
+
+    if(&src == first && (p = leg1.find(opt)) != leg1.end()) {
+      leg1.erase(p);
+      for(it = leg2.begin(); it != leg2.end(); ++it)
+        remove_pair(opt, *it, dead);
+      refill(dead);
+    }
+    if(&src == second && (p = leg2.find(opt)) != leg2.end()) {
+      leg2.erase(p);
+      for(it = leg1.begin(); it != leg1.end(); ++it)
+        remove_pair(*it, opt, dead);
+      refill(dead);
+    }
+  }
+
+  // re-reads the leg(s) src is and recomputes the join:  O(N*M log F)
+  void reloaded(const TravelOptions &src) {
+    if(&src == first)
+      load(src, leg1);
+    if(&src == second)
+      load(src, leg2);
+    recompute();
+  }
+
+  void detached(const TravelOptions &src) {
+    // the result stays valid for the legs as they were; it just stops following them
+    if(&src == first)
+      first = nullptr;
+    if(&src == second)
+      second = nullptr;
+  }
+
+private:
+
+  static void load(const TravelOptions &options, std::multiset<Option> &leg) {
+    leg.clear();
+    for(TravelOptions::const_iterator it = options.begin(); it != options.end(); ++it)
+      leg.insert(Option(it->price, it->time));
+  }
+
+  void recompute() {
+    frontier.clear();
+    std::multiset<Option>::const_iterator a, b;
+    for(a = leg1.begin(); a != leg1.end(); ++a)
+      for(b = leg2.begin(); b != leg2.end(); ++b)
+        add_pair(*a, *b);
+  }
+
+  Option combine(const Option &a, const Option &b) const {
+    if(kind == plus_plus)
+      return Option(a.first + b.first, a.second + b.second);
+    return Option(a.first + b.first, a.second > b.second ? a.second : b.second);
+  }
+
+  /*
+   * Merges one candidate into the frontier:  dropped if dominated, counted if
+   * already present, otherwise inserted and any entries it dominates deleted.
+   * Amortized O(log F).
+   */
+  void add_pair(const Option &a, const Option &b) {
+    Option c = combine(a, b);
+    Frontier::iterator it = frontier.lower_bound(c.first);
+
+    if(it != frontier.end() && it->first == c.first) {
+      if(it->second.first == c.second) {
+        it->second.second++;
+        return;
+      }
+      if(it->second.first < c.second)
+        return;
+    }
+    if(it != frontier.begin()) {
+      Frontier::iterator prev = it;
+      --prev;
+      if(prev->second.first <= c.second)
+        return;
+    }
+    while(it != frontier.end() && it->second.first >= c.second)
+      frontier.erase(it++);
+    frontier.insert(it, std::make_pair(c.first, std::make_pair(c.second, 1)));
+  }
+
+  // retracts one pair; the price of a frontier entry left with no pairs goes to dead
+  void remove_pair(const Option &a, const Option &b, std::vector<double> &dead) {
+    Option c = combine(a, b);
+    Frontier::iterator it = frontier.find(c.first);
+    if(it == frontier.end() || it->second.first != c.second)
+      return;  // the pair was dominated; nothing to retract
+    if(--it->second.second == 0) {
+      frontier.erase(it);
+      dead.push_back(c.first);
+    }
+  }
+
+  /*
+   * A dead entry at price p only dominated pairs priced in [p, q), where q is the
+   * price of the next surviving frontier entry, so only pairs whose price falls in
+   * such a window need to be re-examined.
+   */
+  void refill(std::vector<double> &dead) {
+    if(dead.empty())
+      return;
+    std::sort(dead.begin(), dead.end());
+
+    std::vector<Option> windows;
+    double covered = -std::numeric_limits<double>::infinity();
+    for(size_t i=0; i<dead.size(); i++) {
+      if(dead[i] < covered)
+        continue;
+      Frontier::const_iterator next = frontier.lower_bound(dead[i]);
+      covered = (next == frontier.end()) ? std::numeric_limits<double>::infinity() : next->first;
+      windows.push_back(Option(dead[i], covered));
+    }
+    dead.clear();
+
+    std::multiset<Option>::const_iterator a, b;
+    for(size_t w=0; w<windows.size(); w++) {
+      double lo = windows[w].first, hi = windows[w].second;
+      for(a = leg1.begin(); a != leg1.end(); ++a) {
+        b = leg2.lower_bound(Option(lo - a->first, -std::numeric_limits<double>::infinity()));
+        while(b != leg2.begin()) {  // step back over pairs the subtraction rounded away
+          std::multiset<Option>::const_iterator pb = b;
+          --pb;
+          if(a->first + pb->first < lo)
+            break;
+          b = pb;
+        }
+        for(; b != leg2.end() && a->first + b->first < hi; ++b)
+          add_pair(*a, *b);
+      }
+    }
+  }
+};
+
+#endif
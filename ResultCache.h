@@ -0,0 +1,218 @@
+#ifndef _RESULT_CACHE_H
+#define _RESULT_CACHE_H
+
+#include "TravelOptions.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+
+/**
+ * class: ResultCache
+ * desc: bounded, thread-safe LRU cache of union_pareto_sorted, join_plus_plus and
+ *       join_plus_max results.
+ *
+ *       Entries are keyed by (operation, fingerprint and size of the calling object,
+ *       fingerprint and size of the parameter).  Since fingerprint() only depends on
+ *       which options a list holds (not their order), results of operations whose
+ *       output also depends on the order of the inputs (union_pareto_sorted and
+ *       join_plus_max) are only cached when both inputs are pareto-sorted, where the
+ *       contents determine the order.  Results which are nullptr (preconditions not
+ *       met) are never cached.
+ *
+ *       Results are stored as flat <price,time> arrays and every lookup hands back a
+ *       new TravelOptions object owned by the caller, just like the uncached functions.
+ *       The operation itself runs outside of the lock, so concurrent misses on
+ *       different keys do not serialize.
+ */
+class ResultCache {
+
+public:
+  enum Operation { union_pareto_sorted_op, join_plus_plus_op, join_plus_max_op };
+
+  struct Stats {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    size_t entries;
+    size_t bytes;       // estimated memory held by cached results
+  };
+
+private:
+  struct Key {
+    int op;
+    uint64_t fa, fb;
+    int na, nb;
+
+    bool operator==(const Key &k) const {
+      return op == k.op && fa == k.fa && fb == k.fb && na == k.na && nb == k.nb;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &k) const {
+      uint64_t h = k.fa * 0x9e3779b97f4a7c15ULL;
+      h ^= k.fb + 0x632be59bd9b4e019ULL + (h << 6) + (h >> 2);
+      h ^= ((uint64_t)k.na << 32) ^ (uint64_t)k.nb ^ ((uint64_t)k.op << 61);
+      return (size_t)h;
+    }
+  };
+
+  struct Entry {
+    Key key;
+    std::vector<std::pair<double, double> > options;
+    size_t bytes;
+  };
+
+  typedef std::list<Entry> Lru;  // most recently used at the front
+
+  size_t max_bytes;
+  mutable std::mutex lock;
+  Lru lru;
+  std::unordered_map<Key, Lru::iterator, KeyHash> index;
+  Stats counters;
+
+public:
+  /**
+ * func: constructor
+ * desc: creates an empty cache which holds at most max_bytes (estimated) of results.
+ */
+  ResultCache(size_t _max_bytes = 64 << 20) {
+    max_bytes = _max_bytes;
+    counters.hits = counters.misses = counters.evictions = 0;
+    counters.entries = counters.bytes = 0;
+  }
+
+  /**
+ * func: union_pareto_sorted / join_plus_plus / join_plus_max
+ * desc: same as a.union_pareto_sorted(b) (etc.), but answered from the cache when the
+ *       same inputs have been seen before.
+ * returns: a new TravelOptions object (or nullptr, as the underlying operation).
+ */
+  TravelOptions * union_pareto_sorted(const TravelOptions &a, const TravelOptions &b) {
+    return run(union_pareto_sorted_op, a, b);
+  }
+
+  TravelOptions * join_plus_plus(const TravelOptions &a, const TravelOptions &b) {
+    return run(join_plus_plus_op, a, b);
+  }
+
+  TravelOptions * join_plus_max(const TravelOptions &a, const TravelOptions &b) {
+    return run(join_plus_max_op, a, b);
+  }
+
+  /**
+ * func: stats
+ * desc: returns a snapshot of the hit/miss/eviction counters and current usage.
+ */
+  Stats stats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return counters;
+  }
+
+  /**
+ * func: clear
+ * desc: drops every cached result (counters are kept).
+ */
+  void clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    lru.clear();
+    index.clear();
+    counters.entries = counters.bytes = 0;
+  }
+
+  /**
+ * func: set_max_bytes
+ * desc: changes the memory limit, evicting least recently used results as needed.
+ */
+  void set_max_bytes(size_t bytes) {
+    std::lock_guard<std::mutex> guard(lock);
+    max_bytes = bytes;
+    evict();
+  }
+
+private:
+
+  static TravelOptions * compute(Operation op, const TravelOptions &a, const TravelOptions &b) {
+    if(op == union_pareto_sorted_op)
+      return a.union_pareto_sorted(b);
+    if(op == join_plus_plus_op)
+      return a.join_plus_plus(b);
+    return a.join_plus_max(b);
+  }
+
+  static TravelOptions * build(const std::vector<std::pair<double, double> > &vec) {
+    TravelOptions *options = new TravelOptions();
+    for(size_t i=vec.size(); i>0; i--)
+      options->push_front(vec[i-1].first, vec[i-1].second);
+    return options;
+  }
+
+  TravelOptions * run(Operation op, const TravelOptions &a, const TravelOptions &b) {
+    if(op != join_plus_plus_op && !(a.is_pareto_sorted() && b.is_pareto_sorted())) {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        counters.misses++;
+      }
+      return compute(op, a, b);  // not cacheable by contents; see class comment
+    }
+
+    Key key;
+    key.op = op;
+    key.fa = a.fingerprint();
+    key.fb = b.fingerprint();
+    key.na = a.size();
+    key.nb = b.size();
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      std::unordered_map<Key, Lru::iterator, KeyHash>::iterator it = index.find(key);
+      if(it != index.end()) {
+        counters.hits++;
+        lru.splice(lru.begin(), lru, it->second);
+        return build(it->second->options);
+      }
+      counters.misses++;
+    }
+
+    TravelOptions *result = compute(op, a, b);
+    if(result == nullptr)
+      return nullptr;
+
+    Entry e;
+    e.key = key;
+    std::vector<std::pair<double, double> > *vec = result->to_vec();
+    e.options.swap(*vec);
+    delete vec;
+    e.bytes = sizeof(Entry) + e.options.capacity() * sizeof(std::pair<double, double>);
+
+    std::lock_guard<std::mutex> guard(lock);
+    if(e.bytes > max_bytes || index.count(key) > 0)
+      return result;  // too big to keep, or another thread got there first
+    lru.push_front(Entry());
+    lru.front().key = key;
+    lru.front().options.swap(e.options);
+    lru.front().bytes = e.bytes;
+    index[key] = lru.begin();
+    counters.entries++;
+    counters.bytes += e.bytes;
+    evict();
+    return result;
+  }
+
+  // drops least recently used entries until under the memory limit (lock held)
+  void evict() {
+    while(counters.bytes > max_bytes && !lru.empty()) {
+      Entry &victim = lru.back();
+      index.erase(victim.key);
+      counters.bytes -= victim.bytes;
+      counters.entries--;
+      counters.evictions++;
+      lru.pop_back();
+    }
+  }
+};
+
+#endif
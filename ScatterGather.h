@@ -0,0 +1,270 @@
+#ifndef _SCATTER_GATHER_H
+#define _SCATTER_GATHER_H
+
+#include "TravelOptions.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+#include <utility>
+
+/**
+ * class: ScatterGather
+ * desc: multi-process computation of large frontiers (for batch precomputation, where one
+ *       process is limited by memory bandwidth and allocator contention).
+ *
+ *       The work is split into nprocs parts and a worker process is forked for each.  Every
+ *       worker computes the pareto-sorted frontier of its part in its own address space (so
+ *       with its own allocator, and with its memory placed on the node it runs on), sizes a
+ *       shared-memory file (memfd) created before the fork to exactly that frontier, and
+ *       writes it there as a flat array of <price,time>.  The parent waits for the workers,
+ *       maps the files and merges the k partial frontiers straight out of them with a
+ *       heap-based k-way version of union_pareto_sorted:  nothing is serialized or sent
+ *       through pipes, and no memory is reserved for output a worker does not produce.
+ *
+ *       Like any use of fork, call these from a single-threaded context.
+ */
+class ScatterGather {
+
+  typedef TravelOptions::Option Option;
+
+  /*
+   * read position in a sorted array of options, each shifted by add (-0.0 for "no
+   * shift":  x + -0.0 == x for every x, including both zeros)
+   */
+  struct Cursor {
+    const Option *p, *end;
+    Option add;
+
+    double price() const { return p->price + add.price; }
+    double time() const { return p->time + add.time; }
+
+    // reversed so that the priority_queue pops the smallest <price,time>
+    bool operator<(const Cursor &c) const {
+      return price() > c.price() || (price() == c.price() && time() > c.time());
+    }
+  };
+
+public:
+
+  /**
+ * func: pareto
+ * desc: returns the sorted-pareto list of the given options (as sorted_clone followed by
+ *       prune_sorted), computed by nprocs worker processes on contiguous slices of the input.
+ * returns: a new TravelOptions object, or nullptr if a worker could not be run.
+ */
+  static TravelOptions * pareto(const std::vector<std::pair<double, double> > &options, int nprocs) {
+    std::vector<size_t> cut = slices(options.size(), nprocs);
+
+    return run(cut.size() - 1, [&](int w, std::vector<Option> &out) {
+      std::vector<std::pair<double, double> > part(options.begin() + cut[w], options.begin() + cut[w+1]);
+      TravelOptions *list = TravelOptions::from_vec(part);
+      list->sort();
+      list->prune_sorted();
+      gather(*list, out);
+      delete list;
+    });
+  }
+
+  /**
+ * func: join_plus_plus
+ * desc: returns the same result as a.join_plus_plus(b), computed by nprocs worker processes,
+ *       each joining a slice of a with all of b.
+ *
+ *       Dominated options of either leg can never be part of a pareto option of the join, so
+ *       both are pruned first.  With b pareto-sorted, pairing one option of a with all of b
+ *       gives a sorted row, so each worker produces its frontier with one k-way merge of its
+ *       rows (generated on the fly, never stored).
+ * returns: a new TravelOptions object, or nullptr if a worker could not be run.
+ */
+  static TravelOptions * join_plus_plus(const TravelOptions &a, const TravelOptions &b, int nprocs) {
+    std::vector<Option> first, second;
+    pruned(a, first);
+    pruned(b, second);
+
+    std::vector<size_t> cut = slices(second.empty() ? 0 : first.size(), nprocs);
+    return run(cut.size() - 1, [&](int w, std::vector<Option> &out) {
+      std::vector<Cursor> rows;
+      for(size_t i=cut[w]; i<cut[w+1]; i++) {
+        Cursor c;
+        c.p = second.data();
+        c.end = second.data() + second.size();
+        c.add = first[i];
+        rows.push_back(c);
+      }
+      merge(rows, out);
+    });
+  }
+
+private:
+
+  // boundaries of nprocs (at least one, at most n:  none if n is 0) nearly equal slices of [0, n)
+  static std::vector<size_t> slices(size_t n, int nprocs) {
+    size_t k = std::max(1, nprocs);
+    if(k > n)
+      k = n;
+    std::vector<size_t> cut(k + 1, 0);
+    for(size_t w=1; w<=k; w++)
+      cut[w] = n * w / k;
+    return cut;
+  }
+
+  static void gather(const TravelOptions &list, std::vector<Option> &out) {
+    out.assign(list.begin(), list.end());
+  }
+
+  static void pruned(const TravelOptions &list, std::vector<Option> &out) {
+    TravelOptions *sorted = list.sorted_clone();
+    sorted->prune_sorted();
+    gather(*sorted, out);
+    delete sorted;
+  }
+
+  // worker side:  sizes the (empty) shared file fd to the frontier and copies it in
+  static bool publish(int fd, const std::vector<Option> &frontier) {
+    size_t bytes = frontier.size() * sizeof(Option);
+    if(bytes == 0)
+      return true;
+    if(ftruncate(fd, bytes) != 0)
+      return false;
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED)
+      return false;
+    std::memcpy(p, frontier.data(), bytes);
+    munmap(p, bytes);
+    return true;
+  }
+
+  /*
+   * forks k workers, has worker w run work(w, frontier) and publish the frontier,
+   * waits for all of them and merges their frontiers (an empty list, without forking,
+   * if k is 0).
+   */
+  static TravelOptions * run(size_t k, std::function<void(int, std::vector<Option> &)> work) {
+    std::vector<int> fd(k, -1);
+    std::vector<pid_t> pid(k, -1);
+    std::vector<void *> seg(k, nullptr);
+    std::vector<size_t> bytes(k, 0);
+    bool ok = true;
+
+    for(size_t w=0; w<k && ok; w++) {
+      fd[w] = memfd_create("scatter_gather", MFD_CLOEXEC);
+      ok = fd[w] >= 0;
+    }
+
+    fflush(stdout);
+    for(size_t w=0; w<k && ok; w++) {
+      pid[w] = fork();
+      if(pid[w] == 0) {
+        // the worker must never return into the caller's code (it would run on as a
+        // second copy of the program), not even on bad_alloc
+        try {
+          std::vector<Option> frontier;
+          work(w, frontier);
+          _exit(publish(fd[w], frontier) ? 0 : 1);
+        }
+        catch(...) {
+          _exit(1);
+        }
+      }
+      if(pid[w] < 0)
+        ok = false;
+    }
+    for(size_t w=0; w<k; w++) {
+      int status;
+      if(pid[w] > 0 && (waitpid(pid[w], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0))
+        ok = false;
+    }
+
+    std::vector<Cursor> parts;
+    for(size_t w=0; w<k && ok; w++) {
+      struct stat st;
+      if(fstat(fd[w], &st) != 0 || st.st_size % sizeof(Option) != 0) {
+        ok = false;
+        break;
+      }
+      bytes[w] = st.st_size;
+      if(bytes[w] == 0)
+        continue;
+      seg[w] = mmap(nullptr, bytes[w], PROT_READ, MAP_SHARED, fd[w], 0);
+      if(seg[w] == MAP_FAILED) {
+        seg[w] = nullptr;
+        ok = false;
+        break;
+      }
+      Cursor c;
+      c.p = (const Option *)seg[w];
+      c.end = c.p + bytes[w] / sizeof(Option);
+      c.add.price = c.add.time = -0.0;
+      parts.push_back(c);
+    }
+
+    TravelOptions *result = nullptr;
+    if(ok) {
+      std::vector<Option> out;
+      merge(parts, out);
+      result = new TravelOptions();
+      for(size_t i=out.size(); i>0; i--)
+        result->push_front(out[i-1].price, out[i-1].time);
+    }
+    for(size_t w=0; w<k; w++) {
+      if(seg[w] != nullptr)
+        munmap(seg[w], bytes[w]);
+      if(fd[w] >= 0)
+        close(fd[w]);
+    }
+    return result;
+  }
+
+  /*
+   * k-way union_pareto_sorted of pareto-sorted sequences:  pops options in sorted order
+   * and keeps those strictly faster than every cheaper option kept before (of options
+   * with the same price, the fastest).
+   *
+   * Times only fall along a sequence, so when its head is dominated by the last option
+   * kept, the run of options behind it that are no faster is dominated as well and is
+   * skipped with one binary search.  O((F + k) log n) pops for a frontier of F options
+   * instead of one pop per option.
+   */
+  static void merge(std::vector<Cursor> &cursors, std::vector<Option> &out) {
+    std::priority_queue<Cursor> heap;
+    for(size_t i=0; i<cursors.size(); i++)
+      if(cursors[i].p != cursors[i].end)
+        heap.push(cursors[i]);
+
+    out.clear();
+    while(!heap.empty()) {
+      Cursor c = heap.top();
+      heap.pop();
+      if(out.empty() || c.time() < out.back().time) {
+        if(!out.empty() && c.price() == out.back().price) {
+          out.back().time = c.time();  // a row can hold equal (rounded) prices out of time order
+        }
+        else {
+          Option o;
+          o.price = c.price();
+          o.time = c.time();
+          out.push_back(o);
+        }
+        ++c.p;
+      }
+      else {
+        double shift = c.add.time, limit = out.back().time;
+        c.p = std::partition_point(c.p, c.end, [=](const Option &o) { return o.time + shift >= limit; });
+      }
+      if(c.p != c.end)
+        heap.push(c);
+    }
+  }
+};
+
+#endif
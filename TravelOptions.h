@@ -5,16 +5,70 @@
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <cmath>
+#include <climits>
+#include <cstddef>
+#include <iterator>
 
 class TravelOptions{
 
 public:
   enum Relationship { better, worse, equal, incomparable};
 
-private:
-  struct Node {
+  /**
+   * class: Observer
+   * desc: interface for objects (indexes, materialized results, ...) which need to follow
+   *       the contents of a TravelOptions object.  Once subscribed, the observer is told
+   *       about every option added to or removed from the list.  Bulk changes (clear,
+   *       split_sorted_pareto, ...) are reported with a single reloaded call instead:  the
+   *       observer should re-read the whole list, once.  Every call comes after the change
+   *       is made, so the list (and its size) already shows it.  detached is called when the
+   *       observed list is destroyed (its options are not reported as removed, and the
+   *       observer must not touch it afterwards).
+   */
+  class Observer {
+  public:
+    virtual ~Observer() {}
+    virtual void option_inserted(const TravelOptions &src, double price, double time) = 0;
+    virtual void option_removed(const TravelOptions &src, double price, double time) = 0;
+    virtual void reloaded(const TravelOptions &src) = 0;
+    virtual void detached(const TravelOptions &) {}
+  };
+
+  /**
+   * struct: TimedOption
+   * desc: a scheduled option for one leg of a trip:  its price plus departure and arrival
+   *       timestamps (any consistent unit, e.g. minutes since some epoch).  Input to
+   *       join_connecting.
+   */
+  struct TimedOption {
+    double price;
+    double depart;
+    double arrive;
+
+    TimedOption(double _price=0, double _depart=0, double _arrive=0){
+      price = _price;
+      depart = _depart;
+      arrive = _arrive;
+    }
+  };
+
+  /**
+   * struct: Option
+   * desc: a <price,time> option as seen through the iterators below (each list node
+   *       holds one, so iterating hands out references into the list, not copies).
+   */
+  struct Option {
     double price;
     double time;
+  };
+
+private:
+  struct Node : public Option {
     Node *next;
 
     Node(double _price=0, double _time=0, Node* _next=nullptr){
@@ -28,18 +82,261 @@ private:
   /* TravelOptions private data members */
   Node *front;  // pointer for first node in linked list (or null if list is empty)
   int _size;
+  uint64_t _fingerprint;  // sum of option_hash over all options (see fingerprint)
+  mutable std::vector<Observer*> observers;  // notified of every insertion/removal
+
+  /*
+   * Staircase:  coarse summary of a pareto-sorted list used by insert_pareto_sorted to
+   * reject most dominated candidates in O(1) (see stairs_ready / certainly_dominated).
+   * The price range [lo, lo + cells/inv_w] of the list is cut into equal cells, and
+   * t[b] is the smallest time of an option whose cell is below b.  A candidate in cell b
+   * with time >= t[b] is dominated by an option that is strictly cheaper and no slower.
+   * Valid only while the list is known to be pareto-sorted; any change other than an
+   * exact insert_pareto_sorted drops it, and it is rebuilt on demand.  A list whose
+   * price range is not finite (infinite prices, or a range that overflows) cannot be cut
+   * into cells; its staircase is left unusable and rejects nothing.
+   */
+  struct Staircase {
+    std::vector<double> t;
+    double lo, inv_w;
+    int built_size;  // list size when built (rebuilt once the list has doubled)
+    bool valid;
+    bool usable;     // false if the price range could not be cut into cells
+  };
+  Staircase stairs;
+
+  static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  static uint64_t option_hash(double price, double time) {
+    if(price == 0)
+      price = 0.0;  // -0.0 and 0.0 are the same option
+    if(time == 0)
+      time = 0.0;
+    uint64_t p, t;
+    std::memcpy(&p, &price, sizeof(p));
+    std::memcpy(&t, &time, sizeof(t));
+    return mix64(p ^ mix64(t + 0x9e3779b97f4a7c15ULL));
+  }
+
+  // bookkeeping for every option added to / removed from the list
+  void on_insert(double price, double time) {
+    _fingerprint += option_hash(price, time);
+    stairs.valid = false;
+    for(size_t i=0; i<observers.size(); i++)
+      observers[i]->option_inserted(*this, price, time);
+  }
+
+  void on_remove(double price, double time) {
+    _fingerprint -= option_hash(price, time);
+    stairs.valid = false;
+    for(size_t i=0; i<observers.size(); i++)
+      observers[i]->option_removed(*this, price, time);
+  }
+
+  // bookkeeping for bulk changes (the caller keeps _fingerprint up to date)
+  void on_reload() {
+    stairs.valid = false;
+    for(size_t i=0; i<observers.size(); i++)
+      observers[i]->reloaded(*this);
+  }
+
+  // recomputes _fingerprint for lists built by linking nodes directly
+  void refingerprint() {
+    _fingerprint = 0;
+    stairs.valid = false;
+    for(Node *p = front; p != nullptr; p = p->next)
+      _fingerprint += option_hash(p->price, p->time);
+  }
+
+  // push_front without notification (for callers that notify themselves)
+  void add_front(double price, double time) {
+    front = new Node(price, time, front);
+    _size++;
+  }
+
+  // cell of price in the staircase:  -1 below the range (or NaN), capped at t.size()-1
+  // above it.  Non-decreasing in price, so an option in a lower cell is strictly cheaper
+  int stair_cell(double price) const {
+    if(!(price >= stairs.lo))
+      return -1;
+    double x = (price - stairs.lo) * stairs.inv_w;
+    int last = (int)stairs.t.size() - 1;
+    return !(x < last) ? last : (int)x;  // NaN here is inf*0:  a price far above lo
+  }
+
+  // rebuilds the staircase of a pareto-sorted list.  O(n)
+  void build_stairs() {
+    int cells = std::min(1024, std::max(8, _size));
+    stairs.t.assign(cells + 2, INFINITY);
+    stairs.lo = 0;
+    stairs.inv_w = 0;
+    stairs.built_size = _size;
+    stairs.valid = true;
+    stairs.usable = true;
+    if(front == nullptr)
+      return;
+
+    Node *last = front;
+    while(last->next != nullptr)
+      last = last->next;
+    double range = last->price - front->price;
+    stairs.lo = front->price;
+    if(range > 0)
+      stairs.inv_w = cells / range;
+    stairs.usable = std::isfinite(stairs.lo) && std::isfinite(range) && std::isfinite(stairs.inv_w);
+    if(!stairs.usable)
+      return;
+
+    for(Node *p = front; p != nullptr; p = p->next)
+      stair_lower(p->price, p->time);
+  }
+
+  // accounts for an option <price,time> in the staircase.  O(cells)
+  void stair_lower(double price, double time) {
+    if(!stairs.usable || price != price)
+      return;
+    for(size_t b = stair_cell(price) + 1; b < stairs.t.size(); b++) {
+      if(stairs.t[b] <= time)
+        break;  // t is non-increasing, so the rest is already low enough
+      stairs.t[b] = time;
+    }
+  }
+
+  // true if the list is pareto-sorted, making sure the staircase is up to date.
+  // O(1) while the staircase is valid, else O(n)
+  bool stairs_ready() {
+    if(stairs.valid && _size <= 2*stairs.built_size + 8)
+      return true;
+    if(!stairs.valid && !is_pareto_sorted())
+      return false;
+    build_stairs();
+    return true;
+  }
+
+  // true if <price,time> is certainly dominated by an option of the list (false means
+  // "don't know").  Requires stairs_ready().  O(1)
+  bool certainly_dominated(double price, double time) const {
+    if(!stairs.usable)
+      return false;
+    int b = stair_cell(price);
+    return b >= 0 && stairs.t[b] <= time;
+  }
 
 public:
+  /**
+   * class: const_iterator
+   * desc: STL forward iterator over the options of a list (in list order).  Dereferencing
+   *       gives a const reference to the Option stored in the node:  nothing is copied or
+   *       allocated, so lists can be used directly with <algorithm>, range-for, etc.
+   *       Iterators are invalidated when the option they refer to is removed.
+   */
+  class const_iterator {
+    friend class TravelOptions;
+    const Node *p;
+    const_iterator(const Node *_p) : p(_p) {}
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Option value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Option * pointer;
+    typedef const Option & reference;
+
+    const_iterator() : p(nullptr) {}
+    reference operator*() const { return *p; }
+    pointer operator->() const { return p; }
+    const_iterator & operator++() { p = p->next; return *this; }
+    const_iterator operator++(int) { const_iterator old = *this; p = p->next; return old; }
+    bool operator==(const const_iterator &o) const { return p == o.p; }
+    bool operator!=(const const_iterator &o) const { return p != o.p; }
+  };
+
+  /**
+   * class: column_iterator
+   * desc: forward iterator over just the prices (&Option::price) or just the times
+   *       (&Option::time) of a list, yielding const double references into the nodes.
+   */
+  template <double Option::*Field>
+  class column_iterator {
+    const_iterator it;
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef double value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const double * pointer;
+    typedef const double & reference;
+
+    column_iterator() {}
+    column_iterator(const_iterator _it) : it(_it) {}
+    reference operator*() const { return (*it).*Field; }
+    pointer operator->() const { return &((*it).*Field); }
+    column_iterator & operator++() { ++it; return *this; }
+    column_iterator operator++(int) { column_iterator old = *this; ++it; return old; }
+    bool operator==(const column_iterator &o) const { return it == o.it; }
+    bool operator!=(const column_iterator &o) const { return it != o.it; }
+  };
+
+  typedef column_iterator<&Option::price> price_iterator;
+  typedef column_iterator<&Option::time> time_iterator;
+
+  /**
+   * class: Range
+   * desc: lightweight view of [begin, end) over a list:  two iterators, no copy of the
+   *       options.  Usable in range-for and with any algorithm taking an iterator pair.
+   */
+  template <class Iterator>
+  class Range {
+    Iterator b, e;
+
+  public:
+    Range(Iterator _b, Iterator _e) : b(_b), e(_e) {}
+    Iterator begin() const { return b; }
+    Iterator end() const { return e; }
+    bool empty() const { return b == e; }
+  };
+
   // constructors
   TravelOptions() {
     front = nullptr;
     _size=0;
+    _fingerprint = 0;
+    stairs.valid = false;
+    stairs.usable = false;
   }
 
   ~TravelOptions( ) {
+    // observers keep what they have; they are not told about the options going away
+    for(size_t i=0; i<observers.size(); i++)
+      observers[i]->detached(*this);
+    observers.clear();
     clear();
   }
 
+/**
+ * func: subscribe / unsubscribe
+ * desc: registers (or removes) an Observer to be notified of every change to the list.
+ *       The observer is not told about options already in the list.
+ */
+  void subscribe(Observer *obs) const {
+    observers.push_back(obs);
+  }
+
+  void unsubscribe(Observer *obs) const {
+    for(size_t i=0; i<observers.size(); i++) {
+      if(observers[i] == obs) {
+        observers.erase(observers.begin() + i);
+        return;
+      }
+    }
+  }
+
 /**
  * func: clear
  * desc: Deletes all Nodes currently in the list
@@ -53,7 +350,9 @@ public:
       p = pnxt;
     }
     _size = 0;
+    _fingerprint = 0;
     front = nullptr;
+    on_reload();
   }
 
   /**
@@ -64,6 +363,46 @@ public:
     return _size;
   }
 
+  /**
+ * func: begin / end
+ * desc: const iterators over the options in list order (see const_iterator).
+ */
+  const_iterator begin() const {
+    return const_iterator(front);
+  }
+
+  const_iterator end() const {
+    return const_iterator(nullptr);
+  }
+
+  /**
+ * func: prices / times
+ * desc: views of the price column or the time column of the list (in list order).
+ */
+  Range<price_iterator> prices() const {
+    return Range<price_iterator>(begin(), end());
+  }
+
+  Range<time_iterator> times() const {
+    return Range<time_iterator>(begin(), end());
+  }
+
+  /**
+ * func: within_budget
+ * precondition:  list is sorted.  This is NOT checked (that would scan the whole list);
+ *                on an unsorted list the view is just the leading run of options with
+ *                price <= max_price.
+ * desc: view of the leading options with price <= max_price, without splitting or
+ *       copying the list (compare split_sorted_pareto).
+ * RUNTIME:  linear in the number of options in the view
+ */
+  Range<const_iterator> within_budget(double max_price) const {
+    const Node *p = front;
+    while(p != nullptr && p->price <= max_price)
+      p = p->next;
+    return Range<const_iterator>(begin(), const_iterator(p));
+  }
+
   /**
   * func: compare
   * desc: compares option A (priceA, timeA) with option B (priceB, timeA) and
@@ -122,6 +461,49 @@ private:
     }
     return compare(a->price, a->time, b->price, b->time);
   }
+
+/*
+ * epsilon-dominance helpers.  Each objective is cut into geometric boxes
+ * [(1+eps)^k, (1+eps)^(k+1)); values <= 0 all share the lowest box, and infinite (or
+ * NaN) values the highest.  If the box of option A is no larger than that of option B in
+ * both objectives, then A is within a factor (1+eps) of B in both, and this relation
+ * (unlike "within (1+eps) of") is transitive, so the guarantee does not degrade as
+ * options replace each other.
+ *
+ * Below EPS_MIN the epsilon versions are exact:  (1+eps)*x rounds to x for every double,
+ * so there is nothing to approximate, and box indices |log x| / log1p(eps) <= 745 / 1e-15
+ * of finite values always fit a long long.
+ */
+  struct EpsBox {
+    long long p, t;
+  };
+
+  static constexpr double EPS_MIN = 1e-15;
+
+  static bool exact_eps(double eps) {
+    return !(eps >= EPS_MIN);  // NaN too
+  }
+
+  static long long eps_index(double v, double log1p_eps) {
+    if(!(v > 0))
+      return v != v ? LLONG_MAX : LLONG_MIN;
+    if(v == INFINITY)
+      return LLONG_MAX;
+    return (long long)std::floor(std::log(v) / log1p_eps);
+  }
+
+  // requires !exact_eps(eps) for log1p_eps = log1p(eps)
+  static EpsBox eps_box(double price, double time, double log1p_eps) {
+    EpsBox b;
+    b.p = eps_index(price, log1p_eps);
+    b.t = eps_index(time, log1p_eps);
+    return b;
+  }
+
+  // box a is no larger than box b in both objectives
+  static bool box_covers(const EpsBox &a, const EpsBox &b) {
+    return a.p <= b.p && a.t <= b.t;
+  }
     
   public:
 
@@ -130,8 +512,8 @@ private:
  * desc: Adds a <price,time> option to the front of the list (simple primitive for building lists)
  */
   void push_front(double price, double time) {
-    front = new Node(price, time, front);
-    _size++;
+    add_front(price, time);
+    on_insert(price, time);
   }
 
   /**
@@ -287,16 +669,18 @@ private:
 bool insert_sorted(double price, double time) {
   if(!is_sorted()) 
     return false;
-  
+
   //if list is empty push from front
   if(size() == 0){
-    push_front(price,time);
+    add_front(price,time);
+    on_insert(price, time);
     return true;
   }
 
   //check if the node can be inserted in the front
   if(front->price > price || (front->price == price && front->time >= time)){
-    push_front(price,time);
+    add_front(price,time);
+    on_insert(price, time);
     return true;
   }
 
@@ -310,6 +694,7 @@ bool insert_sorted(double price, double time) {
     if(tmp2->next == nullptr){
         tmp2->next = insertNode;
         _size++;
+        on_insert(price, time);
         return true;
     }
     tmp = tmp2;
@@ -323,6 +708,7 @@ bool insert_sorted(double price, double time) {
       if(tmp2->next == nullptr){
         tmp2->next = insertNode;
         _size++;
+        on_insert(price, time);
         return true;
       }
       tmp = tmp2;
@@ -332,12 +718,14 @@ bool insert_sorted(double price, double time) {
       insertNode->next = tmp2;
       tmp->next = insertNode;
       _size++;
+      on_insert(price, time);
       return true;
     }
     else{
       if(tmp2->next == nullptr){
         tmp2->next = insertNode;
         _size++;
+        on_insert(price, time);
         return true;
       }
       tmp = tmp2;
@@ -347,6 +735,7 @@ bool insert_sorted(double price, double time) {
   insertNode->next = tmp2;
   tmp->next = insertNode;
   _size++;
+  on_insert(price, time);
   return true;
 }
 
@@ -363,20 +752,30 @@ bool insert_sorted(double price, double time) {
  *                newly added option) are deleted.
  *       If the new option is suboptimal, the list is simply unchanged.
  *       In either case, true is returned (i.e., as long as the preconditions are met).
+ *
+ *       A staircase summary of the list (kept up to date by this function, and rebuilt
+ *       after any other change) rejects most dominated options without scanning the list,
+ *       which matters for bulk loads and join_plus_plus where most candidates are dominated.
  *       
- * RUNTIME :  O(n)       
+ * RUNTIME :  O(n) for options that get inserted, typically O(1) for dominated ones
+ *            (the first call after another kind of change is O(n)).
  *
  */
 bool insert_pareto_sorted(double price, double time) {
-  if(!is_pareto_sorted()) 
+  if(!stairs_ready()) 
       return false;
+  if(certainly_dominated(price, time))
+    return true;
 
   Node *tmp = front;
   Node *insertNode = new Node(price,time,nullptr);
 
   //if list is empty
   if(tmp == nullptr){
+    delete insertNode;
     push_front(price,time);
+    stairs.valid = true;
+    stair_lower(price, time);
     return true;
   }
     
@@ -399,21 +798,89 @@ bool insert_pareto_sorted(double price, double time) {
         front = front->next;
         tmp = front;
         before_tmp = tmp;
-        delete erase;
         _size--;
+        on_remove(erase->price, erase->time);
+        delete erase;
       }
       else{
         Node *erase = tmp;
         before_tmp->next = tmp->next;
         tmp = tmp->next;
-        delete erase;
         _size--;
+        on_remove(erase->price, erase->time);
+        delete erase;
       }
     }else{
       before_tmp = tmp;
       tmp = tmp->next;
     };
   }
+  delete insertNode;
+  insert_sorted(price,time);
+
+  // the options removed above are dominated by the new one, so lowering the
+  // staircase for it is all the update it needs
+  stairs.valid = true;
+  stair_lower(price, time);
+  return true;
+}
+
+/**
+ * func: insert_pareto_sorted (epsilon version)
+ * preconditions:  same as insert_pareto_sorted (calling object sorted and pareto).
+ * desc: epsilon-approximate version for lists maintained as an "epsilon-pareto" archive
+ *       (e.g., built only with this function or pruned with prune_sorted(eps)).
+ *       The new option is dropped if an existing option's box (see eps_box) is no larger in
+ *       both objectives, unless they share a box and the new one strictly dominates it (then
+ *       it replaces it).  Otherwise it is inserted and any options whose boxes it covers are
+ *       deleted.
+ *
+ *       Guarantee:  every option ever offered to the list is (1+eps)-dominated by an option
+ *       in it (price <= (1+eps)*price and time <= (1+eps)*time, for positive values), and no two
+ *       options share a price box or a time box, so the list holds at most
+ *       1 + log(max/min)/log(1+eps) options for the price (or time) range it spans.
+ *       eps below EPS_MIN (1e-15, see eps_box), including eps <= 0, is the exact
+ *       insert_pareto_sorted.
+ *
+ * RUNTIME :  O(n), n being the (bounded) size of the archive
+ */
+bool insert_pareto_sorted(double price, double time, double eps) {
+  if(exact_eps(eps))
+    return insert_pareto_sorted(price, time);
+  if(!stairs_ready())
+    return false;
+  if(certainly_dominated(price, time))
+    return true;  // a dominating option's box covers this one's
+
+  double l = std::log1p(eps);
+  EpsBox box = eps_box(price, time, l);
+
+  for(Node *p = front; p != nullptr; p = p->next) {
+    EpsBox pb = eps_box(p->price, p->time, l);
+    if(box_covers(pb, box)) {
+      if(pb.p != box.p || pb.t != box.t || compare(price, time, p->price, p->time) != better)
+        return true;
+    }
+  }
+
+  Node *before_tmp = nullptr, *tmp = front;
+  while(tmp != nullptr){
+    if(box_covers(box, eps_box(tmp->price, tmp->time, l))){
+      Node *erase = tmp;
+      tmp = tmp->next;
+      if(before_tmp == nullptr)
+        front = tmp;
+      else
+        before_tmp->next = tmp;
+      _size--;
+      on_remove(erase->price, erase->time);
+      delete erase;
+    }
+    else{
+      before_tmp = tmp;
+      tmp = tmp->next;
+    }
+  }
   return insert_sorted(price,time);
 }
 
@@ -443,7 +910,6 @@ bool insert_pareto_sorted(double price, double time) {
     if(tmp2 == nullptr){
       unionList->push_front(tmp->price, tmp->time);
       tmp = tmp->next;
-      unionList->_size++;
       tmp2 = unionList->front;
     }
     else{
@@ -466,7 +932,7 @@ bool insert_pareto_sorted(double price, double time) {
       if(unionList->size() == 0){
         unionList->push_front(tmp->price, tmp->time);
         tmp = tmp->next;
-        unionList->_size++;
+        tmp2 = unionList->front;
       }
       else{
         Node* insertNode = new Node(tmp->price, tmp->time, nullptr);
@@ -476,6 +942,7 @@ bool insert_pareto_sorted(double price, double time) {
         unionList->_size++;
       }
     }
+    unionList->refingerprint();
     return unionList;
   }
   else{
@@ -497,7 +964,6 @@ bool insert_pareto_sorted(double price, double time) {
           tmp = tmp->next;
           before_tmp2 = unionList->front;
           tmp2 = before_tmp2->next;
-          unionList->_size++;
         }else{
           Node* insertNode = new Node(tmp->price, tmp->time, nullptr);
           insertNode->next = tmp2;
@@ -512,7 +978,6 @@ bool insert_pareto_sorted(double price, double time) {
         unionList->push_front(tmp->price,tmp->time);
         tmp = tmp->next;
         before_tmp2 = unionList->front;
-        unionList->_size++;
       }
       else{
         Node* insertNode = new Node(tmp->price, tmp->time, nullptr);
@@ -535,7 +1000,8 @@ bool insert_pareto_sorted(double price, double time) {
     }
   }
   //prune the sorted unionList
-  bool x = unionList->prune_sorted();
+  unionList->refingerprint();
+  unionList->prune_sorted();
   return unionList;
 }
     
@@ -564,8 +1030,9 @@ bool insert_pareto_sorted(double price, double time) {
         Node* erase = tmp;
         tmp = tmp->next;
         before_tmp->next = tmp;
-        delete erase;
         _size--;
+        on_remove(erase->price, erase->time);
+        delete erase;
       }
       else if(compare(before_tmp, tmp) == worse){
         if(before_tmp == front){
@@ -573,15 +1040,17 @@ bool insert_pareto_sorted(double price, double time) {
           front = front->next;
           before_tmp = before_tmp->next;
           tmp = tmp->next;
-          delete erase;
           _size--;
+          on_remove(erase->price, erase->time);
+          delete erase;
         }
         else{
           Node* erase = before_tmp;
           before_tmp = before_tmp->next;
           tmp = tmp->next;
-          delete erase;
           _size--;
+          on_remove(erase->price, erase->time);
+          delete erase;
         }
       }
       else{
@@ -592,6 +1061,60 @@ bool insert_pareto_sorted(double price, double time) {
     return true;
   }
 
+  /**
+ * func:  prune_sorted (epsilon version)
+ * precondition:  given collection must be sorted (if not, false is returned).
+ * desc: epsilon-approximate pruning:  besides dominated entries, removes every option whose
+ *         box (see eps_box) is covered by the box of an option that is kept.  Sweeping in
+ *         price order, an option is dropped if the last kept option's time box is no larger;
+ *         it replaces the last kept option if both share a price box.
+ *
+ *         Guarantee:  every removed option is (1+eps)-dominated by a kept option (for positive
+ *         values), and the kept options have distinct price boxes and distinct time boxes, so
+ *         there are at most 1 + log(max/min)/log(1+eps) of them for the price (or time) range.
+ *         eps below EPS_MIN (1e-15, see eps_box), including eps <= 0, is the exact prune_sorted.
+ * RUNTIME:  linear in the length of the list (O(n))
+ */
+  bool prune_sorted(double eps){
+    if(exact_eps(eps))
+      return prune_sorted();
+    if(!is_sorted())
+      return false;
+
+    double l = std::log1p(eps);
+    Node *before_last = nullptr, *last = nullptr, *tmp = front;
+    EpsBox last_box = {0, 0};
+
+    while(tmp != nullptr){
+      EpsBox box = eps_box(tmp->price, tmp->time, l);
+      if(last != nullptr && last_box.t <= box.t){
+        Node *erase = tmp;
+        tmp = tmp->next;
+        last->next = tmp;
+        _size--;
+        on_remove(erase->price, erase->time);
+        delete erase;
+        continue;
+      }
+      if(last != nullptr && last_box.p == box.p){
+        Node *erase = last;
+        if(before_last == nullptr)
+          front = tmp;
+        else
+          before_last->next = tmp;
+        _size--;
+        on_remove(erase->price, erase->time);
+        delete erase;
+        last = before_last;
+      }
+      before_last = last;
+      last = tmp;
+      last_box = box;
+      tmp = tmp->next;
+    }
+    return true;
+  }
+
   /**
  * func: join_plus_plus
  * preconditions:  none -- both the calling object and parameter are just TravelOptions objects (not necessarily
@@ -635,6 +1158,27 @@ bool insert_pareto_sorted(double price, double time) {
     return plusplus;
 }
 
+  /**
+ * func: join_plus_plus (epsilon version)
+ * desc: as join_plus_plus, but every pairing is offered to the result through
+ *       insert_pareto_sorted(price, time, eps), so the result (and the list each candidate is
+ *       checked against while joining) never grows beyond the epsilon size bound.
+ *       Every option of the exact join is (1+eps)-dominated by an option of the result.
+ *       eps below EPS_MIN (1e-15, see eps_box), including eps <= 0, is the exact join_plus_plus.
+ *
+ * RUNTIME:  O(N*M*K) where K is the (bounded) size of the result
+ */
+  TravelOptions * join_plus_plus(const TravelOptions &other, double eps) const {
+    if(exact_eps(eps))
+      return join_plus_plus(other);
+
+    TravelOptions *plusplus = new TravelOptions();
+    for(Node *L1 = front; L1 != nullptr; L1 = L1->next)
+      for(Node *L2 = other.front; L2 != nullptr; L2 = L2->next)
+        plusplus->insert_pareto_sorted(L1->price+L2->price, L1->time+L2->time, eps);
+    return plusplus;
+  }
+
   /**
  * func: join_plus_max
  * preconditions:  both the calling object and the parameter are sorted-pareto lists (if not, nullptr is returned).
@@ -709,24 +1253,495 @@ bool insert_pareto_sorted(double price, double time) {
       }
     }
   }
+  plusmax->refingerprint();
   return plusmax;
 }
 
+  /**
+ * func: join_plus_max (epsilon version)
+ * desc: as join_plus_max, followed by prune_sorted(eps) on the result.  Every option of the
+ *       exact join is (1+eps)-dominated by an option of the result.
+ *       eps below EPS_MIN (1e-15, see eps_box), including eps <= 0, is the exact join_plus_max.
+ *
+ * RUNTIME:  O(N+M) (after the preconditions checks of join_plus_max)
+ */
+  TravelOptions * join_plus_max(const TravelOptions &other, double eps) const {
+    TravelOptions *plusmax = join_plus_max(other);
+    if(plusmax != nullptr && !exact_eps(eps))
+      plusmax->prune_sorted(eps);
+    return plusmax;
+  }
+
+private:
+
+  // sweep orders for join_connecting
+  static bool arrives_before(const TimedOption &a, const TimedOption &b) {
+    return a.arrive < b.arrive;
+  }
+
+  static bool departs_before(const TimedOption &a, const TimedOption &b) {
+    return a.depart < b.depart;
+  }
+
+public:
+
+  /**
+ * func: join_connecting
+ * preconditions:  min_layover <= max_layover (if not, nullptr is returned).
+ * desc: connection-aware version of join_plus_plus.  first gives the scheduled options for the
+ *       X-to-Y leg and second those for the Y-to-Z leg.  Option a of the first leg can only be
+ *       paired with option b of the second leg if the layover in Y is long enough to make the
+ *       connection but not too long:
+ *
+ *           min_layover <= b.depart - a.arrive <= max_layover
+ *
+ *       Such a pairing costs a.price + b.price and arrives in Z at b.arrive.  The result is the
+ *       sorted-pareto list of <total price, arrival time> options for the entire trip.
+ *
+ *       Since the arrival time only depends on b, the best partner for b is the cheapest first
+ *       leg arriving in [b.depart - max_layover, b.depart - min_layover].  With the first leg
+ *       sorted by arrival and the second by departure, that window only slides forward, so its
+ *       minimum is kept in a monotone deque (two pointers) and infeasible pairs are never
+ *       generated.
+ *
+ * RUNTIME:  O(N log N + M log M)
+ */
+  static TravelOptions * join_connecting(const std::vector<TimedOption> &first,
+                                         const std::vector<TimedOption> &second,
+                                         double min_layover, double max_layover) {
+    if(min_layover > max_layover)
+      return nullptr;
+
+    std::vector<TimedOption> L1(first), L2(second);
+    std::sort(L1.begin(), L1.end(), arrives_before);
+    std::sort(L2.begin(), L2.end(), departs_before);
+
+    std::vector<std::pair<double, double> > best;  // <price,arrival> of best pairing per second leg
+    std::vector<size_t> window(L1.size());         // deque of L1 indexes, increasing price
+    size_t head = 0, tail = 0, next = 0;
+
+    for(size_t j=0; j<L2.size(); j++) {
+      while(next < L1.size() && L1[next].arrive <= L2[j].depart - min_layover) {
+        while(tail > head && L1[window[tail-1]].price >= L1[next].price)
+          tail--;
+        window[tail++] = next++;
+      }
+      while(tail > head && L1[window[head]].arrive < L2[j].depart - max_layover)
+        head++;
+      if(tail > head)
+        best.push_back(std::pair<double, double>(L1[window[head]].price + L2[j].price, L2[j].arrive));
+    }
+
+    // keep the pareto options: in price order, each must arrive strictly earlier than all before it
+    std::sort(best.begin(), best.end());
+    TravelOptions *connecting = new TravelOptions();
+    Node *tail_node = nullptr;
+    for(size_t i=0; i<best.size(); i++) {
+      if(tail_node != nullptr && tail_node->time <= best[i].second)
+        continue;
+      Node *n = new Node(best[i].first, best[i].second, nullptr);
+      if(tail_node == nullptr)
+        connecting->front = n;
+      else
+        tail_node->next = n;
+      tail_node = n;
+      connecting->_size++;
+    }
+    connecting->refingerprint();
+    return connecting;
+  }
+
+private:
+
+  /*
+   * Radix sort machinery used by sort() and sorted_clone().
+   *
+   * Each option is mapped to a pair of 64-bit keys whose unsigned order matches
+   * the double order of price and time (flip all bits of negatives, set the sign
+   * bit of non-negatives).  Sorting the 128-bit key <price key, time key> as an
+   * unsigned integer is then the is_sorted() order, except that a price of -0.0 sorts
+   * just before one of 0.0 (see merge_zero_prices).  The keys are exact encodings of
+   * the doubles, so options are written back bit for bit, signs of zeros included.
+   */
+  struct SortKey {
+    uint64_t hi;  // order-preserving bits of price
+    uint64_t lo;  // order-preserving bits of time (tie-breaker)
+  };
+
+  enum {
+    RADIX_BITS = 11,          // 2048 counters per pass stay resident in L1
+    RADIX_BUCKETS = 1 << RADIX_BITS,
+    RADIX_SMALL = 256,        // below this a comparison sort wins
+    RADIX_LSD_MAX = 1 << 15   // at most this many keys (512KB) are LSD sorted in one piece
+  };
+
+  static uint64_t order_key(double d) {
+    uint64_t u;
+    std::memcpy(&u, &d, sizeof(u));
+    return (u & 0x8000000000000000ULL) ? ~u : (u | 0x8000000000000000ULL);
+  }
+
+  static double from_order_key(uint64_t u) {
+    u = (u & 0x8000000000000000ULL) ? (u & ~0x8000000000000000ULL) : ~u;
+    double d;
+    std::memcpy(&d, &u, sizeof(d));
+    return d;
+  }
+
+  // the RADIX_BITS bits of the 128-bit key hi:lo starting at bit 'shift'
+  static unsigned radix_digit(uint64_t hi, uint64_t lo, int shift) {
+    uint64_t w;
+    if(shift >= 64)
+      w = hi >> (shift - 64);
+    else if(shift + RADIX_BITS <= 64)
+      w = lo >> shift;
+    else
+      w = (lo >> shift) | (hi << (64 - shift));
+    return (unsigned)w & (RADIX_BUCKETS-1);
+  }
+
+  static unsigned radix_digit(const SortKey &k, int shift) {
+    return radix_digit(k.hi, k.lo, shift);
+  }
+
+  static bool key_less(const SortKey &a, const SortKey &b) {
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+  }
+
+  /*
+   * Shift of the MSD window for a[0..n): the RADIX_BITS bits ending at the
+   * highest bit on which the keys are not all equal, so that one pass spreads
+   * them as widely as possible.  Returns -1 if all keys are identical.
+   */
+  static int radix_msd_shift(const SortKey *a, size_t n) {
+    uint64_t diff_hi = 0, diff_lo = 0;
+    for(size_t i=1; i<n; i++) {
+      diff_hi |= a[i].hi ^ a[0].hi;
+      diff_lo |= a[i].lo ^ a[0].lo;
+    }
+    int top = -1;
+    for(int b=0; b<64; b++)
+      if((diff_lo >> b) & 1)
+        top = b;
+    for(int b=0; b<64; b++)
+      if((diff_hi >> b) & 1)
+        top = 64 + b;
+    if(top < 0)
+      return -1;
+    return top < RADIX_BITS ? 0 : top - RADIX_BITS + 1;
+  }
+
+  /*
+   * Radix sort of a[0..n), using buf[0..n) as scratch; the result always ends
+   * up in a.  Only bits below nbits are looked at (the caller guarantees that
+   * the higher ones are equal).
+   *
+   * Inputs small enough to stay in cache get an LSD sort (all digit histograms
+   * built in one pass, constant digits skipped).  Larger ones are first split MSD
+   * on their most significant varying bits and each bucket is sorted
+   * recursively, so that the remaining passes run on cache-resident buckets
+   * instead of scattering across the whole array.
+   */
+  static void radix_sort_keys(SortKey *a, SortKey *buf, size_t n, int nbits) {
+    if(n < RADIX_SMALL) {
+      std::sort(a, a+n, key_less);
+      return;
+    }
+    int shift = radix_msd_shift(a, n);
+    if(shift < 0)
+      return;
+
+    if(n > RADIX_LSD_MAX) {
+      std::vector<size_t> c(RADIX_BUCKETS + 1, 0);
+      for(size_t i=0; i<n; i++)
+        c[radix_digit(a[i], shift) + 1]++;
+      for(int b=0; b<RADIX_BUCKETS; b++)
+        c[b+1] += c[b];
+      std::vector<size_t> next(c.begin(), c.end() - 1);
+      for(size_t i=0; i<n; i++)
+        buf[next[radix_digit(a[i], shift)]++] = a[i];
+
+      for(int b=0; b<RADIX_BUCKETS; b++) {
+        size_t lo = c[b], len = c[b+1] - lo;
+        if(len > 1)
+          radix_sort_keys(buf+lo, a+lo, len, shift);
+      }
+      std::memcpy(a, buf, n * sizeof(SortKey));
+      return;
+    }
+
+    int ndigits = (std::min(nbits, shift + (int)RADIX_BITS) + RADIX_BITS - 1) / RADIX_BITS;
+    std::vector<uint32_t> count((size_t)ndigits * RADIX_BUCKETS, 0);
+    for(size_t i=0; i<n; i++)
+      for(int d=0; d<ndigits; d++)
+        count[(size_t)d*RADIX_BUCKETS + radix_digit(a[i], d*RADIX_BITS)]++;
+
+    SortKey *src = a, *dst = buf;
+    for(int d=0; d<ndigits; d++) {
+      uint32_t *c = &count[(size_t)d*RADIX_BUCKETS];
+      if(c[radix_digit(src[0], d*RADIX_BITS)] == n)
+        continue;  // every key has the same digit here
+
+      uint32_t sum = 0;
+      for(int b=0; b<RADIX_BUCKETS; b++) {
+        uint32_t t = c[b];
+        c[b] = sum;
+        sum += t;
+      }
+      for(size_t i=0; i<n; i++)
+        dst[c[radix_digit(src[i], d*RADIX_BITS)]++] = src[i];
+      std::swap(src, dst);
+    }
+    if(src != a)
+      std::memcpy(a, src, n * sizeof(SortKey));
+  }
+
+  /*
+   * Partitioned variant: one MSD pass (histogram and scatter split among the
+   * threads), after which every bucket is independent and the buckets are
+   * handed out to the threads in contiguous, roughly equal-sized ranges.
+   */
+  static void radix_sort_keys_parallel(std::vector<SortKey> &keys, unsigned nthreads) {
+    size_t n = keys.size();
+    std::vector<SortKey> buf(n);
+    if(nthreads <= 1 || n < nthreads * (size_t)RADIX_LSD_MAX) {
+      radix_sort_keys(keys.data(), buf.data(), n, 128);
+      return;
+    }
+
+    int shift = radix_msd_shift(keys.data(), n);
+    if(shift < 0)
+      return;  // all keys identical
+
+    size_t chunk = (n + nthreads - 1) / nthreads;
+    std::vector<std::vector<size_t> > count(nthreads, std::vector<size_t>(RADIX_BUCKETS, 0));
+    std::vector<std::thread> pool;
+
+    for(unsigned t=0; t<nthreads; t++)
+      pool.push_back(std::thread([&, t]() {
+        size_t lo = t*chunk, hi = std::min(n, lo+chunk);
+        for(size_t i=lo; i<hi; i++)
+          count[t][radix_digit(keys[i], shift)]++;
+      }));
+    for(size_t t=0; t<pool.size(); t++)
+      pool[t].join();
+    pool.clear();
+
+    // bucket b of thread t starts after all smaller buckets and after bucket b of threads < t
+    std::vector<size_t> start(RADIX_BUCKETS + 1, 0);
+    size_t sum = 0;
+    for(int b=0; b<RADIX_BUCKETS; b++) {
+      start[b] = sum;
+      for(unsigned t=0; t<nthreads; t++) {
+        size_t c = count[t][b];
+        count[t][b] = sum;
+        sum += c;
+      }
+    }
+    start[RADIX_BUCKETS] = n;
+
+    for(unsigned t=0; t<nthreads; t++)
+      pool.push_back(std::thread([&, t]() {
+        size_t lo = t*chunk, hi = std::min(n, lo+chunk);
+        for(size_t i=lo; i<hi; i++)
+          buf[count[t][radix_digit(keys[i], shift)]++] = keys[i];
+      }));
+    for(size_t t=0; t<pool.size(); t++)
+      pool[t].join();
+    pool.clear();
+
+    // split the buckets among the threads so each gets about n/nthreads keys
+    std::vector<int> first(nthreads + 1, (int)RADIX_BUCKETS);
+    first[0] = 0;
+    for(unsigned t=1, b=0; t<nthreads; t++) {
+      while(b < (unsigned)RADIX_BUCKETS && start[b] < t*chunk)
+        b++;
+      first[t] = b;
+    }
+
+    for(unsigned t=0; t<nthreads; t++)
+      pool.push_back(std::thread([&, t]() {
+        for(int b=first[t]; b<first[t+1]; b++) {
+          size_t lo = start[b], len = start[b+1] - lo;
+          if(len > 1)
+            radix_sort_keys(&buf[lo], &keys[lo], len, shift);
+        }
+      }));
+    for(size_t t=0; t<pool.size(); t++)
+      pool[t].join();
+
+    keys.swap(buf);
+  }
+
+  /*
+   * is_sorted treats prices of -0.0 and 0.0 as equal (ordered by time), but their keys
+   * differ, so after the radix sort options priced -0.0 come before those priced 0.0.
+   * The two runs are adjacent and each sorted by time:  one merge puts them in order.
+   * O(z) for z options priced at zero.
+   */
+  static void merge_zero_prices(std::vector<SortKey> &keys) {
+    SortKey neg = { order_key(-0.0), 0 }, pos = { order_key(0.0), 0 }, above = { order_key(0.0) + 1, 0 };
+    std::vector<SortKey>::iterator first = std::lower_bound(keys.begin(), keys.end(), neg, key_less);
+    std::vector<SortKey>::iterator mid = std::lower_bound(first, keys.end(), pos, key_less);
+    std::vector<SortKey>::iterator last = std::lower_bound(mid, keys.end(), above, key_less);
+    if(first != mid && mid != last)
+      std::inplace_merge(first, mid, last, time_less);
+  }
+
+  static bool time_less(const SortKey &a, const SortKey &b) {
+    return a.lo < b.lo;
+  }
+
+  void to_keys(std::vector<SortKey> &keys) const {
+    keys.resize(_size);
+    size_t i = 0;
+    for(Node *p = front; p != nullptr; p = p->next, i++) {
+      keys[i].hi = order_key(p->price);
+      keys[i].lo = order_key(p->time);
+    }
+  }
+
+  /*
+   * changes every option in place with f(option, index), in one pass over the nodes.
+   * Whether the list was sorted / pareto-sorted before and after is tracked in the same
+   * pass, so the list is only re-sorted (or re-pruned) when the change broke an order it
+   * had:  monotone changes keep it, short of rounding merging neighbouring values.
+   * Observers are told once, with a single reloaded call after all of it (including the
+   * re-prune), instead of one removal and one insertion per option.
+   */
+  template <class F>
+  void apply_in_place(F f) {
+    if(front == nullptr)
+      return;
+    std::vector<Observer *> watching;
+    watching.swap(observers);
+
+    bool was_sorted = true, was_pareto = true, sorted = true, pareto = true;
+    Option before = *front;
+    f(*front, 0);
+    Option after = *front;
+    size_t i = 1;
+    for(Node *p = front->next; p != nullptr; p = p->next, i++) {
+      was_sorted = was_sorted && (before.price < p->price || (before.price == p->price && before.time <= p->time));
+      was_pareto = was_pareto && before.price < p->price && before.time > p->time;
+      before = *p;
+      f(*p, i);
+      sorted = sorted && (after.price < p->price || (after.price == p->price && after.time <= p->time));
+      pareto = pareto && after.price < p->price && after.time > p->time;
+      after = *p;
+    }
+    refingerprint();
+
+    if(was_sorted && !sorted)
+      sort();
+    if(was_pareto && !pareto)
+      prune_sorted();
+
+    observers.swap(watching);
+    on_reload();
+  }
+
+public:
+
+  /**
+ * func: sort
+ * desc: sorts the calling object in place into the order defined by is_sorted (price,
+ *       tie broken by time).  The options are gathered into an array, radix sorted on the
+ *       bit patterns of <price,time> and written back into the existing nodes, so no
+ *       nodes are allocated or relinked.
+ *       With nthreads > 1 the sort is partitioned among that many threads.
+ *
+ * RUNTIME:  O(n)
+ */
+  void sort(unsigned nthreads = 1) {
+    if(_size < 2)
+      return;
+    std::vector<SortKey> keys;
+    to_keys(keys);
+    radix_sort_keys_parallel(keys, nthreads);
+    merge_zero_prices(keys);
+
+    size_t i = 0;
+    for(Node *p = front; p != nullptr; p = p->next, i++) {
+      p->price = from_order_key(keys[i].hi);
+      p->time = from_order_key(keys[i].lo);
+    }
+  }
+
   /**
  * func: sorted_clone
  * desc: returns a sorted TravelOptions object which contains the same elements as the current object
+ *       (radix sorted as in sort(); optionally using nthreads threads).
+ *
+ * RUNTIME:  O(n)
  */
-TravelOptions * sorted_clone() {
+TravelOptions * sorted_clone(unsigned nthreads = 1) const {
   TravelOptions *sorted = new TravelOptions();
-  Node *p = front;
-  
-  while(p != nullptr) {
-    sorted->insert_sorted(p->price, p->time);
-    p = p->next;
-  }
+  std::vector<SortKey> keys;
+  to_keys(keys);
+  radix_sort_keys_parallel(keys, nthreads);
+  merge_zero_prices(keys);
+
+  for(size_t i=keys.size(); i>0; i--)
+    sorted->push_front(from_order_key(keys[i-1].hi), from_order_key(keys[i-1].lo));
   return sorted;
 }
 
+  /**
+ * func: transform
+ * desc: changes every option in place to
+ *
+ *           <price_scale*price + price_shift, time_scale*time + time_shift>
+ *
+ *       (e.g., transform(rate, 0) for a currency conversion, transform(1, 0, 1, delay) for
+ *       a delay) instead of rebuilding the list through to_vec / from_vec.
+ *       Increasing transforms (positive scales) keep a sorted or pareto-sorted list so, and
+ *       nothing more is done.  Otherwise a list that was sorted is sorted again, and one that
+ *       was pareto-sorted is also pruned (e.g., a zero scale leaves only one option).
+ *       Lists that were neither are just transformed.
+ *
+ * RUNTIME:  O(n)  (plus a sort, also O(n), when the transform breaks the order)
+ */
+  void transform(double price_scale, double price_shift, double time_scale = 1, double time_shift = 0) {
+    apply_in_place([=](Option &o, size_t) {
+      o.price = price_scale*o.price + price_shift;
+      o.time = time_scale*o.time + time_shift;
+    });
+  }
+
+  /**
+ * func: add_surcharges
+ * desc: adds extra_price[i] to the price and extra_time[i] to the time of the i-th option
+ *       (in list order), in place.  Either vector may be empty (nothing added to that
+ *       column).  As in transform, the list is re-sorted / re-pruned only if these changes
+ *       broke its order.
+ * returns: false (and changes nothing) if a non-empty vector does not have size() entries.
+ *
+ * RUNTIME:  O(n)  (plus a sort, also O(n), when the surcharges break the order)
+ */
+  bool add_surcharges(const std::vector<double> &extra_price, const std::vector<double> &extra_time) {
+    if((!extra_price.empty() && extra_price.size() != (size_t)_size) ||
+       (!extra_time.empty() && extra_time.size() != (size_t)_size))
+      return false;
+
+    if(extra_time.empty()) {
+      const double *dp = extra_price.data();
+      apply_in_place([=](Option &o, size_t i) { o.price += dp[i]; });
+    }
+    else if(extra_price.empty()) {
+      const double *dt = extra_time.data();
+      apply_in_place([=](Option &o, size_t i) { o.time += dt[i]; });
+    }
+    else {
+      const double *dp = extra_price.data(), *dt = extra_time.data();
+      apply_in_place([=](Option &o, size_t i) {
+        o.price += dp[i];
+        o.time += dt[i];
+      });
+    }
+    return true;
+  }
+
   /**
  * func: split_sorted_pareto
  * precondition:  given list must be both sorted and pareto (if not, nullptr is returned; 
@@ -765,13 +1780,15 @@ TravelOptions * sorted_clone() {
       return greater;
     }
   }
-  if(tmp == front){
+  if(tmp == front)
     front = nullptr;
-    greater->front = tmp;
-    return greater;
-  }
-  before_tmp->next = nullptr;
+  else
+    before_tmp->next = nullptr;
   greater->front = tmp;
+  greater->refingerprint();
+  _size -= greater->_size;
+  _fingerprint -= greater->_fingerprint;
+  on_reload();
   return greater;
 }
 
@@ -790,6 +1807,17 @@ void display(){
   }
 }
 
+/**
+ * func:  fingerprint
+ * desc:  Returns a 64-bit hash of the options in the list (independent of their order and
+ *        of where the nodes live in memory, unlike checksum).  It is kept up to date on
+ *        every insertion and removal, so this is O(1).  Two lists with the same options
+ *        have the same fingerprint; different lists collide only with negligible probability.
+ */
+uint64_t fingerprint() const {
+  return _fingerprint;
+}
+
 /**
  * func:  checksum
  * desc:  Performs and XOR of all node pointers and returns result as
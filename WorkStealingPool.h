@@ -0,0 +1,159 @@
+#ifndef _WORK_STEALING_POOL_H
+#define _WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * class: WorkStealingPool
+ * desc: fixed-size thread pool in which every worker owns a task deque.
+ *
+ *       Tasks submitted by a worker (e.g., a task splitting its work) go to the back of
+ *       that worker's own deque; tasks submitted from outside are spread round-robin.
+ *       A worker takes from the back of its own deque (most recent, cache-warm work) and,
+ *       when that is empty, steals from the front of the other workers' deques, so a
+ *       burst of work landing on one queue is quickly spread over all workers.
+ *       Idle workers sleep on a condition variable instead of spinning.
+ */
+class WorkStealingPool {
+
+  struct Queue {
+    std::mutex lock;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue> > queues;
+  std::vector<std::thread> workers;
+  std::atomic<unsigned> next_queue;
+  std::atomic<long> queued;       // tasks sitting in some deque
+  std::atomic<long> pending;      // tasks submitted and not yet finished
+  bool stopping;
+  std::mutex sleep_lock;
+  std::condition_variable wake, idle;
+
+public:
+  /**
+ * func: constructor
+ * desc: starts nthreads workers (at least one).
+ */
+  WorkStealingPool(unsigned nthreads) : next_queue(0), queued(0), pending(0), stopping(false) {
+    if(nthreads == 0)
+      nthreads = 1;
+    for(unsigned i=0; i<nthreads; i++)
+      queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    for(unsigned i=0; i<nthreads; i++)
+      workers.push_back(std::thread(&WorkStealingPool::run, this, i));
+  }
+
+  /**
+ * func: destructor
+ * desc: finishes every task already submitted, then stops the workers.
+ */
+  ~WorkStealingPool() {
+    wait_idle();
+    {
+      std::lock_guard<std::mutex> guard(sleep_lock);
+      stopping = true;
+    }
+    wake.notify_all();
+    for(size_t i=0; i<workers.size(); i++)
+      workers[i].join();
+  }
+
+  unsigned size() const {
+    return workers.size();
+  }
+
+  /**
+ * func: submit
+ * desc: queues a task for execution by one of the workers.
+ */
+  void submit(std::function<void()> task) {
+    pending++;
+    int self = current_worker();
+    Queue &q = (self >= 0) ? *queues[self] : *queues[next_queue++ % queues.size()];
+    {
+      std::lock_guard<std::mutex> guard(q.lock);
+      q.tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> guard(sleep_lock);
+      queued++;
+    }
+    wake.notify_one();
+  }
+
+  /**
+ * func: wait_idle
+ * desc: blocks until every submitted task has finished.
+ */
+  void wait_idle() {
+    std::unique_lock<std::mutex> guard(sleep_lock);
+    idle.wait(guard, [this]() { return pending == 0; });
+  }
+
+private:
+
+  // index of the calling thread in this pool, or -1 for outside threads
+  int current_worker() const {
+    std::pair<const WorkStealingPool*, int> &me = worker_slot();
+    return me.first == this ? me.second : -1;
+  }
+
+  static std::pair<const WorkStealingPool*, int> & worker_slot() {
+    static thread_local std::pair<const WorkStealingPool*, int> slot(nullptr, -1);
+    return slot;
+  }
+
+  bool take(unsigned self, std::function<void()> &task) {
+    {
+      Queue &q = *queues[self];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if(!q.tasks.empty()) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+      }
+    }
+    for(size_t k=1; k<queues.size(); k++) {
+      Queue &q = *queues[(self + k) % queues.size()];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if(!q.tasks.empty()) {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run(unsigned self) {
+    worker_slot() = std::make_pair((const WorkStealingPool*)this, (int)self);
+    std::function<void()> task;
+
+    while(true) {
+      if(take(self, task)) {
+        queued--;
+        task();
+        task = nullptr;
+        if(--pending == 0) {
+          std::lock_guard<std::mutex> guard(sleep_lock);
+          idle.notify_all();
+        }
+        continue;
+      }
+      std::unique_lock<std::mutex> guard(sleep_lock);
+      wake.wait(guard, [this]() { return stopping || queued > 0; });
+      if(stopping && queued == 0)
+        return;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,500 @@
+#include "TravelOptions.h"
+#include "WorkStealingPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+local batch query server for TravelOptions.
+
+to compile:  g++ -std=c++11 -O2 -pthread server.cpp -o server
+
+usage:  server [-t threads] [-l name=file]... [-s socket_path]
+
+   -t   number of worker threads (default: hardware concurrency)
+   -l   preloads frontier 'name' from 'file' (one "price time" option per line)
+   -s   serves clients on a Unix domain socket instead of stdin/stdout
+
+Requests are lines of text.  A client may send any number of requests without
+waiting for answers (pipelining); every request runs as a task on a shared
+work-stealing pool and answers come back in completion order, tagged with the
+request id:
+
+   <id> UNION  <a> <b>            union_pareto_sorted of frontiers a and b
+   <id> JOIN_PP <a> <b>           join_plus_plus
+   <id> JOIN_PM <a> <b>           join_plus_max
+   <id> SPLIT  <a> <max_price>    options of a priced above max_price
+   <id> BUDGET <a> <max_price>    fastest option of a priced at most max_price
+   LOAD <name> <p>,<t> <p>,<t> ...   (re)defines frontier 'name'
+
+   <id> OK <latency_us> <count> <p>,<t> <p>,<t> ...
+   <id> ERR <latency_us> <message>
+
+Frontiers are stored sorted and pruned.  Latency is measured from the moment a
+request is parsed until its answer is formatted.  When stdin reaches end of file
+(or a socket client disconnects) a summary of that client's requests (count,
+throughput, latency percentiles) goes to stderr.
+
+Every client has its own writer thread, so pool workers never block on a client
+which is slow to read its answers; a client with too many unread answers stops
+being read until it catches up, and one which goes away is just dropped.
+*/
+
+typedef std::chrono::steady_clock Clock;
+typedef std::shared_ptr<const TravelOptions> Frontier;
+
+/*
+ * named frontiers:  requests grab shared pointers when they are parsed, so a LOAD
+ * can replace a frontier while requests against the old one are still running.
+ */
+class Catalog {
+  std::mutex lock;
+  std::map<std::string, Frontier> frontiers;
+
+public:
+  void put(const std::string &name, std::vector<std::pair<double, double> > &vec) {
+    TravelOptions *options = TravelOptions::from_vec(vec);
+    TravelOptions *sorted = options->sorted_clone();
+    delete options;
+    sorted->prune_sorted();
+
+    std::lock_guard<std::mutex> guard(lock);
+    frontiers[name] = Frontier(sorted);
+  }
+
+  Frontier get(const std::string &name) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::map<std::string, Frontier>::iterator it = frontiers.find(name);
+    return it == frontiers.end() ? Frontier() : it->second;
+  }
+};
+
+/*
+ * latency samples of all answered requests
+ */
+class Stats {
+  std::mutex lock;
+  std::vector<double> latencies;
+
+public:
+  void add(double us) {
+    std::lock_guard<std::mutex> guard(lock);
+    latencies.push_back(us);
+  }
+
+  // who (if not empty) prefixes both lines, to tell clients apart
+  void report(double seconds, const std::string &who) {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t n = latencies.size();
+    if(n == 0)
+      return;
+    std::sort(latencies.begin(), latencies.end());
+    fprintf(stderr, "%srequests: %zu  time: %.3f s  throughput: %.0f req/s\n"
+            "%slatency us:  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+            who.c_str(), n, seconds, n / seconds,
+            who.c_str(), latencies[n/2], latencies[n*9/10], latencies[n*99/100], latencies[n-1]);
+  }
+};
+
+/*
+ * one client:  pool workers append answers to a buffer, and the connection's own
+ * writer thread sends them when the buffer fills up or when no more requests of
+ * that client are in flight.  Only the writer thread ever blocks on the client.
+ * A failed write (e.g., EPIPE:  the client went away) drops all further output.
+ * The reader stops taking requests while MAX_INFLIGHT of them are queued or running
+ * (each is a pool task that keeps its frontiers alive) or MAX_BUFFERED bytes of
+ * answers are unsent, so a pipelining client cannot make the server's memory grow
+ * without bound.
+ */
+class Connection {
+  enum { FLUSH_BYTES = 1 << 16, MAX_BUFFERED = 1 << 22, MAX_INFLIGHT = 1 << 12 };
+
+  int fd;
+  std::mutex lock;
+  std::condition_variable wake;   // signaled whenever out, inflight or broken change
+  std::string out;
+  long inflight;
+  bool closing, broken;
+  std::thread writer;
+
+  static bool write_all(int fd, const char *data, size_t len) {
+    while(len > 0) {
+      ssize_t n = ::write(fd, data, len);
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        return false;
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  void run_writer() {
+    std::string batch;
+    std::unique_lock<std::mutex> guard(lock);
+    while(true) {
+      wake.wait(guard, [this]() {
+        return closing || (!out.empty() && (inflight == 0 || out.size() >= FLUSH_BYTES));
+      });
+      if(out.empty())
+        return;  // closing, and everything has been sent
+      batch.swap(out);
+      guard.unlock();
+      bool ok = write_all(fd, batch.data(), batch.size());
+      batch.clear();
+      guard.lock();
+      if(!ok)
+        broken = true;
+      if(broken)
+        out.clear();
+      wake.notify_all();
+    }
+  }
+
+public:
+  Connection(int _fd) : fd(_fd), inflight(0), closing(false), broken(false) {
+    writer = std::thread(&Connection::run_writer, this);
+  }
+
+  ~Connection() {
+    wait_drained();
+  }
+
+  void started() {
+    std::lock_guard<std::mutex> guard(lock);
+    inflight++;
+  }
+
+  void answer(const std::string &line) {
+    std::lock_guard<std::mutex> guard(lock);
+    if(!broken)
+      out += line;
+    inflight--;
+    wake.notify_all();
+  }
+
+  // true once the client can no longer be written to
+  bool gone() {
+    std::lock_guard<std::mutex> guard(lock);
+    return broken;
+  }
+
+  // blocks the reader while too many requests are in flight or answers waiting to be sent
+  void throttle() {
+    std::unique_lock<std::mutex> guard(lock);
+    wake.wait(guard, [this]() {
+      return broken || (inflight < MAX_INFLIGHT && out.size() < MAX_BUFFERED);
+    });
+  }
+
+  // waits for every request in flight, sends the remaining answers, stops the writer
+  void wait_drained() {
+    std::unique_lock<std::mutex> guard(lock);
+    wake.wait(guard, [this]() { return inflight == 0; });
+    closing = true;
+    wake.notify_all();
+    guard.unlock();
+    if(writer.joinable())
+      writer.join();
+  }
+};
+
+enum Op { op_union, op_join_pp, op_join_pm, op_split, op_budget };
+
+struct Request {
+  std::string id;
+  Op op;
+  Frontier a, b;
+  double param;
+  Clock::time_point start;
+};
+
+static void append_options(std::string &line, const TravelOptions &options) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), " %d", options.size());
+  line += buf;
+  for(TravelOptions::const_iterator it = options.begin(); it != options.end(); ++it) {
+    snprintf(buf, sizeof(buf), " %.17g,%.17g", it->price, it->time);
+    line += buf;
+  }
+}
+
+static void execute(const Request &req, Connection &conn, Stats &stats) {
+  TravelOptions *result = nullptr;
+  std::string err;
+
+  switch(req.op) {
+    case op_union:
+      result = req.a->union_pareto_sorted(*req.b);
+      break;
+    case op_join_pp:
+      result = req.a->join_plus_plus(*req.b);
+      break;
+    case op_join_pm:
+      result = req.a->join_plus_max(*req.b);
+      break;
+    case op_split: {
+      // what split_sorted_pareto would return, without modifying the shared frontier
+      std::vector<std::pair<double, double> > vec;
+      for(TravelOptions::const_iterator it = req.a->begin(); it != req.a->end(); ++it)
+        if(it->price > req.param)
+          vec.push_back(std::pair<double, double>(it->price, it->time));
+      result = TravelOptions::from_vec(vec);
+      break;
+    }
+    case op_budget: {
+      TravelOptions::Range<TravelOptions::const_iterator> fits = req.a->within_budget(req.param);
+      result = new TravelOptions();
+      TravelOptions::const_iterator last = fits.end();
+      for(TravelOptions::const_iterator it = fits.begin(); it != fits.end(); ++it)
+        last = it;
+      if(last != fits.end())
+        result->push_front(last->price, last->time);
+      break;
+    }
+  }
+  if(result == nullptr)
+    err = "preconditions not met";
+
+  std::string line = req.id;
+  double us = std::chrono::duration<double, std::micro>(Clock::now() - req.start).count();
+  char buf[64];
+  snprintf(buf, sizeof(buf), err.empty() ? " OK %.1f" : " ERR %.1f", us);
+  line += buf;
+
+  if(err.empty())
+    append_options(line, *result);
+  else
+    line += " " + err;
+  line += "\n";
+
+  delete result;
+  stats.add(us);
+  conn.answer(line);
+}
+
+static void split_words(const std::string &line, std::vector<std::string> &words) {
+  words.clear();
+  size_t i = 0;
+  while(i < line.size()) {
+    while(i < line.size() && isspace((unsigned char)line[i]))
+      i++;
+    size_t j = i;
+    while(j < line.size() && !isspace((unsigned char)line[j]))
+      j++;
+    if(j > i)
+      words.push_back(line.substr(i, j - i));
+    i = j;
+  }
+}
+
+static bool parse_option(const std::string &word, std::pair<double, double> &opt) {
+  const char *s = word.c_str();
+  char *end;
+  opt.first = strtod(s, &end);
+  if(end == s || *end != ',')
+    return false;
+  s = end + 1;
+  opt.second = strtod(s, &end);
+  return end != s && *end == '\0';
+}
+
+/*
+ * parses one request line and hands it to the pool (or answers errors directly)
+ */
+static void dispatch(const std::string &line, Catalog &catalog, WorkStealingPool &pool,
+                     const std::shared_ptr<Connection> &conn, Stats &stats) {
+  std::vector<std::string> words;
+  split_words(line, words);
+  if(words.empty())
+    return;
+
+  if(words[0] == "LOAD") {
+    if(words.size() < 2)
+      return;
+    std::vector<std::pair<double, double> > vec;
+    std::pair<double, double> opt;
+    for(size_t i=2; i<words.size(); i++)
+      if(parse_option(words[i], opt))
+        vec.push_back(opt);
+    catalog.put(words[1], vec);
+    return;
+  }
+
+  std::shared_ptr<Request> req(new Request());
+  req->start = Clock::now();
+  req->id = words[0];
+  std::string err;
+
+  if(words.size() != 4)
+    err = "expected: <id> <op> <frontier> <frontier|price>";
+  else {
+    const std::string &op = words[1];
+    bool binary = true;
+    if(op == "UNION")
+      req->op = op_union;
+    else if(op == "JOIN_PP")
+      req->op = op_join_pp;
+    else if(op == "JOIN_PM")
+      req->op = op_join_pm;
+    else if(op == "SPLIT" || op == "BUDGET") {
+      req->op = (op == "SPLIT") ? op_split : op_budget;
+      binary = false;
+    }
+    else
+      err = "unknown operation " + op;
+
+    if(err.empty()) {
+      req->a = catalog.get(words[2]);
+      if(!req->a)
+        err = "unknown frontier " + words[2];
+      else if(binary) {
+        req->b = catalog.get(words[3]);
+        if(!req->b)
+          err = "unknown frontier " + words[3];
+      }
+      else {
+        char *end;
+        req->param = strtod(words[3].c_str(), &end);
+        if(*end != '\0')
+          err = "bad price " + words[3];
+      }
+    }
+  }
+
+  conn->started();
+  if(!err.empty()) {
+    conn->answer(req->id + " ERR 0.0 " + err + "\n");
+    return;
+  }
+  std::shared_ptr<Connection> c = conn;
+  Stats *s = &stats;
+  pool.submit([req, c, s]() { execute(*req, *c, *s); });
+}
+
+static bool load_file(Catalog &catalog, const std::string &spec) {
+  size_t eq = spec.find('=');
+  if(eq == std::string::npos)
+    return false;
+  std::ifstream in(spec.substr(eq + 1).c_str());
+  if(!in)
+    return false;
+  std::vector<std::pair<double, double> > vec;
+  double p, t;
+  while(in >> p >> t)
+    vec.push_back(std::pair<double, double>(p, t));
+  catalog.put(spec.substr(0, eq), vec);
+  return true;
+}
+
+/*
+ * reads requests from in_fd until end of file (or until the client can no longer be
+ * answered) and answers them on out_fd; reports the client's stats when done.
+ */
+static void serve(int in_fd, int out_fd, Catalog &catalog, WorkStealingPool &pool, const std::string &who) {
+  Stats stats;
+  std::shared_ptr<Connection> conn(new Connection(out_fd));
+  Clock::time_point start = Clock::now();
+  std::vector<char> buf(1 << 16);
+  std::string pending;
+
+  while(!conn->gone()) {
+    ssize_t n = read(in_fd, buf.data(), buf.size());
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      break;
+    pending.append(buf.data(), n);
+    size_t from = 0, nl;
+    while((nl = pending.find('\n', from)) != std::string::npos) {
+      conn->throttle();
+      dispatch(pending.substr(from, nl - from), catalog, pool, conn, stats);
+      from = nl + 1;
+    }
+    pending.erase(0, from);
+  }
+  if(!pending.empty() && !conn->gone())
+    dispatch(pending, catalog, pool, conn, stats);
+
+  conn->wait_drained();
+  stats.report(std::chrono::duration<double>(Clock::now() - start).count(), who);
+}
+
+static void serve_client(int fd, Catalog &catalog, WorkStealingPool &pool, int client) {
+  char who[32];
+  snprintf(who, sizeof(who), "client %d: ", client);
+  serve(fd, fd, catalog, pool, who);
+  close(fd);
+}
+
+static int serve_socket(const char *path, Catalog &catalog, WorkStealingPool &pool) {
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+
+  if(listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0) {
+    perror("server: socket");
+    return 1;
+  }
+  for(int client = 1; ; client++) {
+    int fd = accept(listener, nullptr, nullptr);
+    if(fd < 0)
+      continue;
+    std::thread(serve_client, fd, std::ref(catalog), std::ref(pool), client).detach();
+  }
+}
+
+int main(int argc, char *argv[]){
+  unsigned threads = std::thread::hardware_concurrency();
+  const char *socket_path = nullptr;
+  Catalog catalog;
+
+  // a client going away must not kill the server:  its writes fail with EPIPE instead
+  signal(SIGPIPE, SIG_IGN);
+
+  for(int i=1; i<argc; i++) {
+    if(strcmp(argv[i], "-t") == 0 && i+1 < argc)
+      threads = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-s") == 0 && i+1 < argc)
+      socket_path = argv[++i];
+    else if(strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+      if(!load_file(catalog, argv[++i])) {
+        fprintf(stderr, "server: cannot load %s\n", argv[i]);
+        return 1;
+      }
+    }
+    else {
+      fprintf(stderr, "usage: %s [-t threads] [-l name=file]... [-s socket_path]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  WorkStealingPool pool(threads);
+  if(socket_path != nullptr)
+    return serve_socket(socket_path, catalog, pool);
+  serve(0, 1, catalog, pool, "");
+  return 0;
+}
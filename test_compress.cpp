@@ -0,0 +1,148 @@
+#include "TravelOptions.h"
+#include "CompressedFrontier.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <random>
+#include <cmath>
+
+/*
+tester for CompressedFrontier.
+
+to compile:  g++ -std=c++11 test_compress.cpp
+
+for random pareto-sorted lists (whole numbers, cents, values that
+need the raw bit patterns, geometric growth for deltas of every
+width, negative and infinite values, lengths around the block size)
+checks that decode and decompress give back exactly the same doubles
+(bit for bit), and compares fastest_within_budget and
+cheapest_within_time with a scan of the list for queries at, between
+and beyond the options.  then checks that a list which is not
+pareto-sorted is refused.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+
+static uint64_t bits(double x){
+   uint64_t u;
+   memcpy(&u, &x, sizeof(u));
+   return u;
+}
+
+static bool same(const Vec &a, const Vec &b){
+   if(a.size() != b.size())
+      return false;
+   for(size_t i=0; i<a.size(); i++)
+      if(bits(a[i].first) != bits(b[i].first) || bits(a[i].second) != bits(b[i].second))
+         return false;
+   return true;
+}
+
+// a pareto-sorted frontier of n options, in one of a few kinds of values
+static Vec frontier(std::mt19937_64 &rng, int n, int kind){
+   Vec v;
+   double price = (kind == 3) ? -1000 : 10, time = 1e6;
+   double ratio = std::ldexp(1e-6, -(int)(rng() % 24));   // kind 4:  growth per option
+   for(int i=0; i<n; i++){
+      switch(kind){
+         case 0:  price += 1 + rng() % 500;            time -= 1 + rng() % 100;           break;
+         case 1:  price += (1 + rng() % 500) / 100.0;  time -= 1 + rng() % 100;           break;
+         case 2:  price += std::ldexp((double)(1 + rng() % 1000), -7) * 1.37;
+                  time -= (1 + rng() % 1000) * 0.001137;                                  break;
+         case 3:  price += (1 + rng() % 70000) * 0.25; time -= 1 + rng() % 3;             break;
+         default: price *= 1 + (1 + rng() % 1000) * ratio;  time /= 1 + (1 + rng() % 1000) * ratio;
+      }
+      v.push_back(std::make_pair(price, time));
+   }
+   if(kind == 3 && n > 1)
+      v.back().first = INFINITY;   // no finite scale fits:  the column is stored as bit patterns
+   return v;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 400;
+   std::mt19937_64 rng(32);
+   int bad = 0;
+
+   for(int r=0; r<rounds; r++){
+      int kind = r % 5;
+      int n = (r < 8) ? r : (r % 5 == 0) ? CompressedFrontier::BLOCK * (1 + rng() % 3) + (int)(rng() % 3) - 1 : rng() % 700;
+      Vec v = frontier(rng, n, kind);
+      TravelOptions *list = TravelOptions::from_vec(v);
+      CompressedFrontier *cf = CompressedFrontier::compress(*list);
+      if(cf == nullptr || cf->size() != n){
+         std::cout << "round " << r << ": a pareto-sorted list of " << n << " options was not compressed\n";
+         bad++;
+         delete cf;
+         delete list;
+         continue;
+      }
+
+      Vec decoded;
+      std::vector<double> prices, times;
+      cf->decode(prices, times);
+      for(size_t i=0; i<prices.size(); i++)
+         decoded.push_back(std::make_pair(prices[i], times[i]));
+      TravelOptions *back = cf->decompress();
+      Vec *restored = back->to_vec();
+      if(!same(decoded, v) || !same(*restored, v)){
+         std::cout << "round " << r << ": decode / decompress do not give back the list\n";
+         bad++;
+      }
+      delete restored;
+      delete back;
+
+      for(int q=0; q<60; q++){
+         double budget, max_time, price = 0, time = 0;
+         if(n > 0 && q % 3 != 2){
+            budget = v[rng() % n].first - (q % 3 ? 0 : 0.001);
+            max_time = v[rng() % n].second + (q % 3 ? 0 : 0.001);
+         }
+         else {
+            budget = (q % 2) ? -1e9 : 1e300;
+            max_time = (q % 2) ? 1e300 : -1e9;
+         }
+
+         int k = -1;
+         for(int i=0; i<n; i++)
+            if(v[i].first <= budget)
+               k = i;
+         bool found = cf->fastest_within_budget(budget, price, time);
+         if(found != (k >= 0) || (found && (price != v[k].first || time != v[k].second))){
+            std::cout << "round " << r << ": fastest_within_budget(" << budget << ") is wrong\n";
+            bad++;
+         }
+
+         k = -1;
+         for(int i=n-1; i>=0; i--)
+            if(v[i].second <= max_time)
+               k = i;
+         found = cf->cheapest_within_time(max_time, price, time);
+         if(found != (k >= 0) || (found && (price != v[k].first || time != v[k].second))){
+            std::cout << "round " << r << ": cheapest_within_time(" << max_time << ") is wrong\n";
+            bad++;
+         }
+      }
+      delete cf;
+      delete list;
+   }
+
+   Vec unsorted;
+   unsorted.push_back(std::make_pair(2.0, 1.0));
+   unsorted.push_back(std::make_pair(1.0, 2.0));
+   TravelOptions *list = TravelOptions::from_vec(unsorted);
+   CompressedFrontier *cf = CompressedFrontier::compress(*list);
+   if(cf != nullptr){
+      std::cout << "a list that is not pareto-sorted was compressed\n";
+      bad++;
+   }
+   delete cf;
+   delete list;
+
+   std::cout << "CompressedFrontier: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include "TravelOptions.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+
+/*
+tester for join_connecting.
+
+to compile:  g++ -std=c++11 test_connect.cpp
+
+for random schedules (with ties in prices, departures and arrivals,
+and empty legs) and layover windows (empty, a single value, negative
+bounds, wider than any gap) compares join_connecting with a
+brute-force join:  every pair of options whose layover is inside the
+window, sorted and pruned with sorted_clone + prune_sorted.  then
+checks that min_layover > max_layover gives nullptr.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef TravelOptions::TimedOption Timed;
+typedef std::vector<std::pair<double, double>> Vec;
+
+static std::vector<Timed> schedule(std::mt19937 &rng, int n, int span){
+   std::vector<Timed> leg;
+   for(int i=0; i<n; i++){
+      double depart = rng() % span;
+      leg.push_back(Timed(1 + rng() % 30, depart, depart + 1 + rng() % 20));
+   }
+   return leg;
+}
+
+static TravelOptions * brute_connecting(const std::vector<Timed> &first, const std::vector<Timed> &second,
+                                        double min_layover, double max_layover){
+   Vec all;
+   for(size_t i=0; i<first.size(); i++)
+      for(size_t j=0; j<second.size(); j++){
+         double layover = second[j].depart - first[i].arrive;
+         if(min_layover <= layover && layover <= max_layover)
+            all.push_back(std::make_pair(first[i].price + second[j].price, second[j].arrive));
+      }
+   TravelOptions *options = TravelOptions::from_vec(all);
+   TravelOptions *pareto = options->sorted_clone();
+   pareto->prune_sorted();
+   delete options;
+   return pareto;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 1000;
+   std::mt19937 rng(30);
+   int bad = 0;
+
+   for(int r=0; r<rounds; r++){
+      int span = 10 + r % 100;
+      std::vector<Timed> first = schedule(rng, rng() % 40, span), second = schedule(rng, rng() % 40, span + 20);
+      double min_layover = (int)(rng() % 30) - 10;
+      double max_layover = (r % 7 == 0) ? min_layover : min_layover + rng() % (r % 2 ? 10 : 200);
+
+      TravelOptions *got = TravelOptions::join_connecting(first, second, min_layover, max_layover);
+      TravelOptions *expect = brute_connecting(first, second, min_layover, max_layover);
+      Vec *a = got->to_vec(), *b = expect->to_vec();
+      if(*a != *b || !got->is_pareto_sorted()){
+         std::cout << "round " << r << ": join_connecting with layovers [" << min_layover << ","
+                   << max_layover << "] gives " << a->size() << " options, expected " << b->size() << "\n";
+         bad++;
+      }
+      delete a;
+      delete b;
+      delete got;
+      delete expect;
+   }
+
+   std::vector<Timed> leg;
+   leg.push_back(Timed(5, 0, 10));
+   if(TravelOptions::join_connecting(leg, leg, 20, 10) != nullptr){
+      std::cout << "min_layover > max_layover did not give nullptr\n";
+      bad++;
+   }
+
+   std::cout << "join_connecting: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include "TravelOptions.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+#include <cmath>
+
+/*
+tester for the epsilon versions of prune_sorted, insert_pareto_sorted,
+join_plus_plus and join_plus_max.
+
+to compile:  g++ -std=c++11 test_eps.cpp
+
+for random lists and a few values of eps, checks the guarantee
+against a brute-force scan:  the result is pareto-sorted, every
+option offered (or of the exact join) has an option of the result
+within a factor (1+eps) in both price and time, and the result is no
+larger than 1 + log(max/min)/log(1+eps) (+1 for rounding).  then
+checks that eps below 1e-15 gives exactly the exact results, and that
+infinite values are kept where they are not dominated.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+
+// every option of all is within (1+eps) of an option of list (log() rounding allowed for)
+static bool covered(const Vec &all, const TravelOptions &list, double eps){
+   double f = (1 + eps) * (1 + 1e-12);
+   for(size_t i=0; i<all.size(); i++){
+      bool found = false;
+      for(TravelOptions::const_iterator it = list.begin(); it != list.end() && !found; ++it)
+         found = it->price <= f * all[i].first && it->time <= f * all[i].second;
+      if(!found)
+         return false;
+   }
+   return true;
+}
+
+static bool small_enough(const TravelOptions &list, double lo, double hi, double eps){
+   return list.size() <= 2 + std::log(hi / lo) / std::log1p(eps);
+}
+
+static bool same(const TravelOptions &a, const TravelOptions &b){
+   Vec *x = a.to_vec(), *y = b.to_vec();
+   bool equal = (*x == *y);
+   delete x;
+   delete y;
+   return equal;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 300;
+   std::mt19937 rng(6);
+   std::uniform_real_distribution<double> value(1, 1000);
+   int bad = 0;
+
+   for(int r=0; r<rounds; r++){
+      double eps = (r % 4 + 1) * 0.05;
+      Vec all;
+      for(int i=0; i<200; i++){
+         double price = value(rng);
+         all.push_back(std::make_pair(price, 2000 - price + value(rng) * (r % 2 ? 0.3 : 2)));
+      }
+      TravelOptions *options = TravelOptions::from_vec(all);
+
+      TravelOptions *pruned = options->sorted_clone();
+      pruned->prune_sorted(eps);
+      if(!pruned->is_pareto_sorted() || !covered(all, *pruned, eps) || !small_enough(*pruned, 1, 1000, eps)){
+         std::cout << "round " << r << ": prune_sorted(" << eps << ") breaks the guarantee\n";
+         bad++;
+      }
+
+      TravelOptions archive;
+      for(size_t i=0; i<all.size(); i++)
+         archive.insert_pareto_sorted(all[i].first, all[i].second, eps);
+      if(!archive.is_pareto_sorted() || !covered(all, archive, eps) || !small_enough(archive, 1, 1000, eps)){
+         std::cout << "round " << r << ": insert_pareto_sorted(" << eps << ") breaks the guarantee\n";
+         bad++;
+      }
+
+      Vec first(all.begin(), all.begin() + 30), second(all.begin() + 30, all.begin() + 60);
+      TravelOptions *a = TravelOptions::from_vec(first), *b = TravelOptions::from_vec(second);
+      TravelOptions *exact = a->join_plus_plus(*b), *approx = a->join_plus_plus(*b, eps);
+      Vec *joined = exact->to_vec();
+      if(!approx->is_pareto_sorted() || !covered(*joined, *approx, eps) || approx->size() > exact->size()){
+         std::cout << "round " << r << ": join_plus_plus(" << eps << ") breaks the guarantee\n";
+         bad++;
+      }
+      delete joined;
+      delete exact;
+      delete approx;
+
+      TravelOptions *as = a->sorted_clone(), *bs = b->sorted_clone();
+      as->prune_sorted();
+      bs->prune_sorted();
+      exact = as->join_plus_max(*bs);
+      approx = as->join_plus_max(*bs, eps);
+      joined = exact->to_vec();
+      if(approx == nullptr || !covered(*joined, *approx, eps)){
+         std::cout << "round " << r << ": join_plus_max(" << eps << ") breaks the guarantee\n";
+         bad++;
+      }
+      delete joined;
+      delete exact;
+      delete approx;
+      delete as;
+      delete bs;
+      delete a;
+      delete b;
+
+      // below the floor the epsilon versions are the exact ones
+      double tiny = (r % 2) ? 1e-20 : 1e-300;
+      TravelOptions *exact_pruned = options->sorted_clone(), *tiny_pruned = options->sorted_clone();
+      exact_pruned->prune_sorted();
+      tiny_pruned->prune_sorted(tiny);
+      TravelOptions exact_archive, tiny_archive;
+      for(size_t i=0; i<all.size(); i++){
+         exact_archive.insert_pareto_sorted(all[i].first, all[i].second);
+         tiny_archive.insert_pareto_sorted(all[i].first, all[i].second, tiny);
+      }
+      if(!same(*exact_pruned, *tiny_pruned) || !same(exact_archive, tiny_archive)){
+         std::cout << "round " << r << ": eps = " << tiny << " is not exact\n";
+         bad++;
+      }
+      delete exact_pruned;
+      delete tiny_pruned;
+      delete pruned;
+      delete options;
+   }
+
+   TravelOptions small;
+   small.insert_pareto_sorted(5, 5, 1e-20);
+   small.insert_pareto_sorted(4, 6, 1e-20);
+   if(small.size() != 2){
+      std::cout << "eps = 1e-20 dropped an option that is not dominated\n";
+      bad++;
+   }
+
+   TravelOptions infinite;
+   infinite.insert_pareto_sorted(INFINITY, 1, 0.1);
+   infinite.insert_pareto_sorted(1, INFINITY, 0.1);
+   infinite.insert_pareto_sorted(2, 2, 0.1);
+   if(infinite.size() != 3 || !infinite.is_pareto_sorted()){
+      std::cout << "infinite values:  " << infinite.size() << " options kept instead of 3\n";
+      bad++;
+   }
+
+   std::cout << "epsilon versions: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include "TravelOptions.h"
+#include "BulkExport.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <random>
+#include <limits>
+
+/*
+tester for BulkExport's number format and binary format.
+
+to compile:  g++ -std=c++11 test_format.cpp
+
+checks that BulkExport::format writes every double (random bit
+patterns, subnormals, zeros of both signs, infinities, prices on
+a cent grid) as a decimal that strtod reads back as exactly the
+same double, in at most MAX_FIELD characters, and that lists
+written with write_binary come back unchanged from read_binary,
+while truncated files, and files whose header claims far more options
+than they hold, give nullptr (without allocating for that count).
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+
+static bool same_double(double a, double b){
+   if(a != a || b != b)
+      return a != a && b != b;
+   return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static int check_format(double v){
+   char buf[BulkExport::MAX_FIELD + 1];
+   char *end = BulkExport::format(v, buf);
+   *end = '\0';
+   if(end - buf > BulkExport::MAX_FIELD || !same_double(strtod(buf, nullptr), v)){
+      printf("format(%.17g) wrote \"%s\"\n", v, buf);
+      return 1;
+   }
+   return 0;
+}
+
+static int check_binary(const Vec &vec){
+   FILE *f = tmpfile();
+   if(f == nullptr)
+      return 1;
+   Vec copy = vec;
+   TravelOptions *options = TravelOptions::from_vec(copy);
+   TravelOptions *back = nullptr;
+   int bad = 0;
+
+   if(!BulkExport::write_binary(*options, fileno(f)) || lseek(fileno(f), 0, SEEK_SET) != 0 ||
+      (back = BulkExport::read_binary(fileno(f))) == nullptr){
+      std::cout << "binary round trip of " << vec.size() << " options failed\n";
+      bad = 1;
+   }
+   else {
+      Vec *got = back->to_vec();
+      for(size_t i=0; i<vec.size() && bad == 0; i++)
+         if(got->size() != vec.size() || !same_double((*got)[i].first, vec[i].first) ||
+            !same_double((*got)[i].second, vec[i].second))
+            bad = 1;
+      if(bad)
+         std::cout << "binary round trip of " << vec.size() << " options changed them\n";
+      delete got;
+   }
+   delete back;
+   delete options;
+   fclose(f);
+   return bad;
+}
+
+// a binary file of count options with only the first keep bytes after the header
+static int check_truncated(uint64_t count, size_t keep){
+   FILE *f = tmpfile();
+   if(f == nullptr)
+      return 1;
+   std::vector<char> data(keep, 0);
+   fwrite("TRVLOPT1", 1, 8, f);
+   fwrite(&count, sizeof(count), 1, f);
+   if(keep > 0)
+      fwrite(data.data(), 1, keep, f);
+   fflush(f);
+   lseek(fileno(f), 0, SEEK_SET);
+   TravelOptions *back = BulkExport::read_binary(fileno(f));
+   fclose(f);
+   if(back != nullptr){
+      std::cout << "read_binary accepted " << keep << " bytes for " << count << " options\n";
+      delete back;
+      return 1;
+   }
+   return 0;
+}
+
+int main(int argc, char *argv[]){
+   int count = (argc > 1) ? atoi(argv[1]) : 200000;
+   std::mt19937_64 rng(4);
+   int bad = 0;
+
+   const double special[] = { 0.0, -0.0, 1.0, 0.1, 0.3, 1e21, 1e22, 123456.789, 9007199254740992.0,
+                              5e-324, 2.2250738585072009e-308, 2.2250738585072014e-308,
+                              std::numeric_limits<double>::max(), std::numeric_limits<double>::min(),
+                              std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN() };
+   for(size_t i=0; i<sizeof(special)/sizeof(special[0]); i++)
+      bad += check_format(special[i]) + check_format(-special[i]);
+
+   for(int i=0; i<count; i++){
+      uint64_t bits = rng();
+      double v;
+      memcpy(&v, &bits, sizeof(double));
+      bad += check_format(v);                           // any bit pattern
+      bad += check_format((double)(bits % 10000000) / 100);   // prices in cents
+      bad += check_format(ldexp((double)(bits >> 12), -1074)); // subnormals
+   }
+
+   Vec vec;
+   bad += check_binary(vec);
+   for(int i=0; i<300000; i++){
+      uint64_t p = rng(), t = rng();
+      double price, time;
+      memcpy(&price, &p, sizeof(double));
+      memcpy(&time, &t, sizeof(double));
+      vec.push_back(std::make_pair(price, time));
+      if(i == 0 || i == 65535 || i == 65536 || i == 299999)
+         bad += check_binary(vec);
+   }
+
+   bad += check_truncated(3, 40);
+   bad += check_truncated(100000, 8*100000 + 8);
+   bad += check_truncated(2000000000, 64);
+
+   std::cout << "format: " << count << " rounds, binary: 8 lists, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include "TravelOptions.h"
+#include "HullIndex.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+
+/*
+tester for HullIndex.
+
+to compile:  g++ -std=c++11 test_hull.cpp
+
+every round keeps an index over a random list, changes the list
+with a random sequence of calls (push_front, insert_sorted,
+insert_pareto_sorted and prune_sorted, exact and with an eps (which
+remove hull vertices that are not dominated), transform,
+split_sorted_pareto, clear) and after each call compares argmin and
+argmin_sorted, for lambdas from 0 up to far beyond every breakpoint,
+with a scan of the list for the minimum of price + lambda*time (of
+the options reaching it, the cheapest).  all values are small
+integers and lambdas multiples of 1/8, so scores are exact.  then
+checks the empty and negative-lambda cases and that an index can
+outlive its list.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+// the minimum of price + lambda*time over the list, and the cheapest option reaching it
+static bool brute_argmin(const TravelOptions &list, double lambda, double &price, double &time){
+   bool found = false;
+   double best = 0;
+   for(TravelOptions::const_iterator it = list.begin(); it != list.end(); ++it){
+      double score = it->price + lambda * it->time;
+      if(!found || score < best || (score == best && it->price < price)){
+         found = true;
+         best = score;
+         price = it->price;
+         time = it->time;
+      }
+   }
+   return found;
+}
+
+// got is a minimizer for lambda if it scores like expect and costs the same
+static bool same(double lambda, double gp, double gt, double ep, double et){
+   return gp + lambda * gt == ep + lambda * et && gp == ep;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 200;
+   std::mt19937 rng(27);
+   int bad = 0;
+
+   std::vector<double> lambdas;
+   for(int k=0; k<=400; k++)
+      lambdas.push_back(k / 8.0);
+   lambdas.push_back(1e9);
+
+   for(int r=0; r<rounds; r++){
+      std::uniform_int_distribution<int> coord(0, 10 + r % 60);
+      TravelOptions *list = new TravelOptions();
+      for(int i=0; i<r % 20; i++)
+         list->push_front(coord(rng), coord(rng));
+      HullIndex index(*list);
+
+      for(int step=0; step<60; step++){
+         double price = coord(rng), time = coord(rng);
+
+         switch(rng() % 14){
+            case 0:
+               list->sort();
+               list->prune_sorted();
+               break;
+            case 1:
+               list->transform(1 + rng() % 3, -(double)(rng() % 5), (rng() % 2) ? 1 : -1, 20);
+               break;
+            case 2:
+               if(list->is_pareto_sorted())
+                  delete list->split_sorted_pareto(price);
+               break;
+            case 3:
+               if(rng() % 4 == 0)
+                  list->clear();
+               break;
+            case 4:
+            case 5:
+               list->sort();
+               list->insert_sorted(price, time);
+               break;
+            case 6:
+            case 7:
+            case 8:
+               if(!list->is_pareto_sorted()){
+                  list->sort();
+                  list->prune_sorted();
+               }
+               list->insert_pareto_sorted(price, time);
+               break;
+            case 9:
+               if(!list->is_pareto_sorted()){
+                  list->sort();
+                  list->prune_sorted();
+               }
+               list->insert_pareto_sorted(price, time, 0.3);
+               break;
+            case 10:
+               list->sort();
+               list->prune_sorted(0.2);
+               break;
+            default:
+               list->push_front(price, time);
+               break;
+         }
+
+         std::vector<std::pair<double, double>> batch;
+         bool batched = index.argmin_sorted(lambdas, batch);
+         if(batched != (list->size() > 0)){
+            std::cout << "round " << r << ", step " << step << ": argmin_sorted returned " << batched << "\n";
+            bad++;
+         }
+         for(size_t i=0; i<lambdas.size(); i++){
+            double ep = 0, et = 0, gp = 0, gt = 0;
+            bool expect = brute_argmin(*list, lambdas[i], ep, et);
+            bool got = index.argmin(lambdas[i], gp, gt);
+            if(got != expect || (got && !same(lambdas[i], gp, gt, ep, et))){
+               std::cout << "round " << r << ", step " << step << ": argmin(" << lambdas[i] << ") gives <"
+                         << gp << "," << gt << ">, expected <" << ep << "," << et << ">\n";
+               bad++;
+            }
+            else if(batched && (batch[i].first != gp || batch[i].second != gt)){
+               std::cout << "round " << r << ", step " << step << ": argmin_sorted differs from argmin at "
+                         << lambdas[i] << "\n";
+               bad++;
+            }
+         }
+      }
+      delete list;
+   }
+
+   TravelOptions empty;
+   HullIndex none(empty);
+   std::vector<std::pair<double, double>> out;
+   double price, time;
+   if(none.argmin(1, price, time) || none.argmin_sorted(lambdas, out)){
+      std::cout << "an empty index answered a query\n";
+      bad++;
+   }
+
+   TravelOptions *list = new TravelOptions();
+   list->push_front(3, 1);
+   list->push_front(1, 3);
+   HullIndex *index = new HullIndex(*list);
+   std::vector<double> unsorted;
+   unsorted.push_back(2);
+   unsorted.push_back(1);
+   if(index->argmin(-1, price, time) || index->argmin_sorted(unsorted, out)){
+      std::cout << "a negative or unsorted lambda was answered\n";
+      bad++;
+   }
+   delete list;    // the index is detached, and must not touch the list again
+   delete index;
+
+   std::cout << "HullIndex: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include "TravelOptions.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+/*
+tester for insert_pareto_sorted (and the staircase that rejects
+dominated options without scanning the list).
+
+to compile:  g++ -std=c++11 test_insert.cpp
+
+every round feeds random options (on a coarse grid, so that ties
+and duplicates are common) to insert_pareto_sorted and compares
+the list after each call with a brute-force frontier of everything
+offered so far.  other kinds of changes (push_front + prune_sorted,
+clear) are mixed in so the staircase gets invalidated and rebuilt.
+some rounds also offer prices of +-inf and +-1e308, whose price
+range cannot be cut into staircase cells.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+
+// sorted-pareto frontier of all options in vec:  O(n^2), on purpose
+static Vec brute_frontier(const Vec &vec){
+   Vec front;
+   for(size_t i=0; i<vec.size(); i++){
+      bool dominated = false;
+      for(size_t j=0; j<vec.size() && !dominated; j++){
+         if(j == i)
+            continue;
+         bool no_worse = vec[j].first <= vec[i].first && vec[j].second <= vec[i].second;
+         bool better = vec[j].first < vec[i].first || vec[j].second < vec[i].second;
+         // of identical options only the first one is kept
+         dominated = no_worse && (better || j < i);
+      }
+      if(!dominated)
+         front.push_back(vec[i]);
+   }
+   std::sort(front.begin(), front.end());
+   return front;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 200;
+   std::mt19937 rng(1);
+   const double extreme[] = { INFINITY, -INFINITY, 1e308, -1e308 };
+   int bad = 0;
+
+   // lists with an infinite price range, then an option that is not dominated
+   Vec cases[2] = { {{1,10},{INFINITY,1}}, {{-1e308,10},{1e308,1}} };
+   double extra[2][2] = { {5,2}, {0,2} };
+   for(int c=0; c<2; c++){
+      TravelOptions *options = TravelOptions::from_vec(cases[c]);
+      options->insert_pareto_sorted(extra[c][0], extra[c][1]);
+      if(options->size() != 3){
+         std::cout << "infinite price range " << c << ": an option that is not dominated was dropped\n";
+         bad++;
+      }
+      delete options;
+   }
+
+   for(int r=0; r<rounds; r++){
+      int grid = 5 + r % 50;
+      std::uniform_int_distribution<int> coord(0, grid);
+      double scale = (r % 3 == 0) ? 0.1 : 1;  // some rounds with fractional values
+
+      TravelOptions *options = new TravelOptions();
+      Vec offered;
+      int n = 1 + r % 300;
+
+      for(int i=0; i<n; i++){
+         double price = coord(rng) * scale, time = coord(rng) * scale;
+         if(r % 4 == 3 && rng() % 8 == 0)
+            price = extreme[rng() % 4];
+
+         if(i % 97 == 96){
+            // a change the staircase does not follow:  it has to be rebuilt
+            options->push_front(price, time);
+            options->sort();
+            options->prune_sorted();
+         }
+         else if(i % 151 == 150){
+            options->clear();
+            offered.clear();
+            continue;
+         }
+         else if(!options->insert_pareto_sorted(price, time)){
+            std::cout << "round " << r << ": insert_pareto_sorted refused a pareto-sorted list\n";
+            bad++;
+            break;
+         }
+         offered.push_back(std::make_pair(price, time));
+
+         Vec *got = options->to_vec();
+         if(*got != brute_frontier(offered)){
+            std::cout << "round " << r << ", option " << i << ": list differs from the brute-force frontier\n";
+            bad++;
+         }
+         delete got;
+      }
+      delete options;
+   }
+
+   std::cout << "insert_pareto_sorted: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include "TravelOptions.h"
+#include "MaterializedJoin.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+
+/*
+tester for MaterializedJoin.
+
+to compile:  g++ -std=c++11 test_join.cpp
+
+every round keeps a join_plus_plus and a join_plus_max over two
+random legs, changes the legs with a random sequence of calls
+(push_front, insert_sorted, insert_pareto_sorted, sort +
+prune_sorted, transform, split_sorted_pareto, clear) and after
+each call compares both joins with the join recomputed from
+scratch by TravelOptions::join_plus_plus / join_plus_max.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+
+// the sorted-pareto version of list, for join_plus_max (which requires it)
+static TravelOptions * pareto_clone(const TravelOptions &list){
+   TravelOptions *clone = list.sorted_clone();
+   clone->prune_sorted();
+   return clone;
+}
+
+static bool same(const MaterializedJoin &join, TravelOptions *expect){
+   TravelOptions *got = join.result();
+   Vec *a = got->to_vec(), *b = expect->to_vec();
+   bool equal = (*a == *b);
+   delete a;
+   delete b;
+   delete got;
+   delete expect;
+   return equal;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 100;
+   std::mt19937 rng(3);
+   int bad = 0;
+
+   for(int r=0; r<rounds; r++){
+      std::uniform_int_distribution<int> coord(0, 10 + r % 40);
+      TravelOptions *legs[2] = { new TravelOptions(), new TravelOptions() };
+      for(int i=0; i<5; i++){
+         legs[0]->push_front(coord(rng), coord(rng));
+         legs[1]->push_front(coord(rng), coord(rng));
+      }
+      MaterializedJoin plus(*legs[0], *legs[1], MaterializedJoin::plus_plus);
+      MaterializedJoin max(*legs[0], *legs[1], MaterializedJoin::plus_max);
+
+      for(int step=0; step<60; step++){
+         TravelOptions *leg = legs[rng() % 2];
+         double price = coord(rng), time = coord(rng);
+
+         switch(rng() % 12){
+            case 0:
+               leg->sort();
+               leg->prune_sorted();
+               break;
+            case 1:
+               leg->transform(1 + rng() % 3, -(double)(rng() % 5), (rng() % 2) ? 1 : -1, 20);
+               break;
+            case 2:
+               if(leg->is_pareto_sorted())
+                  delete leg->split_sorted_pareto(price);
+               break;
+            case 3:
+               if(rng() % 4 == 0)
+                  leg->clear();
+               break;
+            case 4:
+            case 5:
+               leg->sort();
+               leg->insert_sorted(price, time);
+               break;
+            case 6:
+            case 7:
+               if(!leg->is_pareto_sorted()){
+                  leg->sort();
+                  leg->prune_sorted();
+               }
+               leg->insert_pareto_sorted(price, time);
+               break;
+            default:
+               leg->push_front(price, time);
+               break;
+         }
+
+         TravelOptions *a = pareto_clone(*legs[0]), *b = pareto_clone(*legs[1]);
+         if(!same(plus, legs[0]->join_plus_plus(*legs[1]))){
+            std::cout << "round " << r << ", step " << step << ": join_plus_plus differs from a recompute\n";
+            bad++;
+         }
+         if(!same(max, a->join_plus_max(*b))){
+            std::cout << "round " << r << ", step " << step << ": join_plus_max differs from a recompute\n";
+            bad++;
+         }
+         delete a;
+         delete b;
+      }
+      delete legs[0];
+      delete legs[1];
+   }
+
+   std::cout << "MaterializedJoin: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include "TravelOptions.h"
+#include "ScatterGather.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <iostream>
+#include <random>
+
+/*
+tester for ScatterGather.
+
+to compile:  g++ -std=c++11 test_scatter.cpp
+
+compares ScatterGather::pareto with sorted_clone + prune_sorted and
+ScatterGather::join_plus_plus with TravelOptions::join_plus_plus on
+random lists (with ties, fractional values and empty legs), for 1 to
+5 worker processes.  then checks that empty input gives an empty
+list, and that a worker running out of memory makes the call return
+nullptr in the calling process only (no worker runs on past it).
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+
+static bool same(TravelOptions *got, TravelOptions *expect){
+   if(got == nullptr || expect == nullptr)
+      return false;
+   Vec *a = got->to_vec(), *b = expect->to_vec();
+   bool equal = (*a == *b) && got->is_pareto_sorted();
+   delete a;
+   delete b;
+   return equal;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 300;
+   std::mt19937 rng(5);
+   pid_t self = getpid();
+   int bad = 0;
+
+   for(int r=0; r<rounds; r++){
+      std::uniform_int_distribution<int> coord(0, 60);
+      bool fraction = (r % 3 == 0);
+      Vec a, b;
+      int n = rng() % 40, m = rng() % 40;
+      for(int i=0; i<n; i++)
+         a.push_back(std::make_pair(fraction ? coord(rng)*0.1 : coord(rng), fraction ? coord(rng)*0.7 : coord(rng)));
+      for(int i=0; i<m; i++)
+         b.push_back(std::make_pair(coord(rng)*(fraction ? 0.3 : 0.5), coord(rng)*(fraction ? 0.1 : 0.25)));
+      int nprocs = 1 + r % 5;
+
+      TravelOptions *A = TravelOptions::from_vec(a), *B = TravelOptions::from_vec(b);
+      TravelOptions *expect = A->join_plus_plus(*B);
+      TravelOptions *got = ScatterGather::join_plus_plus(*A, *B, nprocs);
+      if(!same(got, expect)){
+         std::cout << "round " << r << ": join_plus_plus with " << nprocs << " workers differs\n";
+         bad++;
+      }
+      delete expect;
+      delete got;
+
+      expect = A->sorted_clone();
+      expect->prune_sorted();
+      got = ScatterGather::pareto(a, nprocs);
+      if(!same(got, expect)){
+         std::cout << "round " << r << ": pareto with " << nprocs << " workers differs\n";
+         bad++;
+      }
+      delete expect;
+      delete got;
+      delete A;
+      delete B;
+   }
+
+   Vec none;
+   TravelOptions *got = ScatterGather::pareto(none, 4);
+   if(got == nullptr || got->size() != 0){
+      std::cout << "pareto of no options is not an empty list\n";
+      bad++;
+   }
+   delete got;
+
+   // a limit on the address space the workers cannot stay within
+   Vec big;
+   for(int i=0; i<4000000; i++)
+      big.push_back(std::make_pair((double)(i % 1000), (double)(i % 777)));
+   long pages = 0;
+   FILE *f = fopen("/proc/self/statm", "r");
+   if(f != nullptr){
+      if(fscanf(f, "%ld", &pages) != 1)
+         pages = 0;
+      fclose(f);
+   }
+   struct rlimit before, limit;
+   if(pages > 0 && getrlimit(RLIMIT_AS, &before) == 0){
+      limit = before;
+      limit.rlim_cur = pages * sysconf(_SC_PAGESIZE) + (40L << 20);
+      setrlimit(RLIMIT_AS, &limit);
+      try {
+         got = ScatterGather::pareto(big, 2);
+      }
+      catch(...) {
+         got = nullptr;
+      }
+      if(getpid() != self){
+         std::cout << "a worker that ran out of memory returned from ScatterGather::pareto\n";
+         _exit(2);
+      }
+      setrlimit(RLIMIT_AS, &before);
+      if(got != nullptr){
+         std::cout << "pareto returned a list although its workers ran out of memory\n";
+         bad++;
+      }
+      delete got;
+   }
+
+   std::cout << "ScatterGather: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}
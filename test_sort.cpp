@@ -0,0 +1,98 @@
+#include "TravelOptions.h"
+
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+/*
+tester for the radix sort behind sort() and sorted_clone().
+
+to compile:  g++ -std=c++11 -pthread test_sort.cpp
+
+every round builds a random list (with negative values, zeros of
+both signs, infinities, duplicates and, for some rounds, enough
+options to go through the multi-threaded path) and checks that
+sort() and sorted_clone() give the same options as std::sort of
+to_vec(), and that sorted_clone() leaves its source alone.  since
+-0.0 == 0.0, the values are also compared bit for bit:  sorting
+must not change any option, including the sign of a zero.
+
+prints the number of mismatches; exits with 1 if there were any.
+*/
+
+typedef std::vector<std::pair<double, double>> Vec;
+typedef std::vector<std::pair<uint64_t, uint64_t>> Bits;
+
+// the options as bit patterns, in list order (sorted, if canonical is set)
+static Bits bits(const Vec &vec, bool canonical){
+   Bits out(vec.size());
+   for(size_t i=0; i<vec.size(); i++){
+      memcpy(&out[i].first, &vec[i].first, sizeof(double));
+      memcpy(&out[i].second, &vec[i].second, sizeof(double));
+   }
+   if(canonical)
+      std::sort(out.begin(), out.end());
+   return out;
+}
+
+int main(int argc, char *argv[]){
+   int rounds = (argc > 1) ? atoi(argv[1]) : 100;
+   std::mt19937 rng(2);
+   const double special[] = { 0.0, -0.0, 1.0, -1.0, 1e-310, -1e-310, 1e300, -1e300,
+                              std::numeric_limits<double>::infinity(),
+                              -std::numeric_limits<double>::infinity() };
+   int bad = 0;
+
+   for(int r=0; r<rounds; r++){
+      size_t n = (r % 10 == 9) ? 200000 + rng() % 100000 : rng() % 2000;
+      unsigned nthreads = 1 + r % 4;
+      std::uniform_int_distribution<int> small(-20, 20);
+      std::uniform_real_distribution<double> wide(-1e6, 1e6);
+
+      Vec vec;
+      for(size_t i=0; i<n; i++){
+         double price, time;
+         switch(rng() % 3){
+            case 0:  price = small(rng); time = small(rng); break;
+            case 1:  price = wide(rng); time = wide(rng); break;
+            default: price = special[rng() % 10]; time = special[rng() % 10]; break;
+         }
+         vec.push_back(std::make_pair(price, time));
+      }
+
+      Vec expect = vec;
+      std::sort(expect.begin(), expect.end());
+
+      TravelOptions *options = TravelOptions::from_vec(vec);
+      TravelOptions *clone = options->sorted_clone(nthreads);
+      Vec *before = options->to_vec();
+      Vec *cloned = clone->to_vec();
+      if(*cloned != expect || !clone->is_sorted() || bits(*cloned, true) != bits(vec, true)){
+         std::cout << "round " << r << ": sorted_clone(" << nthreads << ") differs from std::sort\n";
+         bad++;
+      }
+      if(bits(*before, false) != bits(vec, false)){
+         std::cout << "round " << r << ": sorted_clone changed its source\n";
+         bad++;
+      }
+
+      options->sort(nthreads);
+      Vec *sorted = options->to_vec();
+      if(*sorted != expect || !options->is_sorted() || bits(*sorted, true) != bits(vec, true)){
+         std::cout << "round " << r << ": sort(" << nthreads << ") differs from std::sort\n";
+         bad++;
+      }
+
+      delete before;
+      delete cloned;
+      delete sorted;
+      delete clone;
+      delete options;
+   }
+
+   std::cout << "sort: " << rounds << " rounds, " << bad << " mismatches\n";
+   return bad == 0 ? 0 : 1;
+}